@@ -27,6 +27,11 @@
 
 #include "P_AIO.h"
 
+#if (AIO_MODE == AIO_MODE_IO_URING)
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#endif
+
 #define MAX_DISKS_POSSIBLE 100
 
 // globals
@@ -43,6 +48,7 @@ static ink_mutex insert_mutex;
 Continuation *aio_err_callbck = 0;
 RecInt cache_config_threads_per_disk = 12;
 RecInt api_config_threads_per_disk = 12;
+RecInt cache_config_io_uring_entries = 1024;
 int thread_is_created = 0;
 
 
@@ -160,6 +166,9 @@ ink_aio_init(ModuleVersion v)
   ink_mutex_init(&insert_mutex, NULL);
 
   IOCORE_ReadConfigInteger(cache_config_threads_per_disk, "proxy.config.cache.threads_per_disk");
+#if (AIO_MODE == AIO_MODE_IO_URING)
+  IOCORE_ReadConfigInteger(cache_config_io_uring_entries, "proxy.config.cache.io_uring_entries");
+#endif
 }
 
 int
@@ -416,6 +425,328 @@ cache_op(AIOCallbackInternal *op)
   return 1;
 }
 
+#if (AIO_MODE == AIO_MODE_IO_URING)
+/*
+ * io_uring
+ *
+ * Each net thread owns a ring. There is no liburing dependency, the rings
+ * are mapped and driven through the raw syscalls. A thread without a ring
+ * (task threads, API requests, or a kernel without io_uring) falls back to
+ * the AIO thread pool above.
+ */
+
+static inline int
+sys_io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+  return (int) syscall(__NR_io_uring_setup, entries, p);
+}
+
+static inline int
+sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+  return (int) syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static inline int
+sys_io_uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args)
+{
+  return (int) syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+DiskHandler::DiskHandler()
+  : Continuation(new_ProxyMutex()), ring_fd(-1), sq_head(NULL), sq_tail(NULL), sq_mask(NULL), sq_array(NULL),
+    sq_entries(0), sqes(NULL), cq_head(NULL), cq_tail(NULL), cq_mask(NULL), cqes(NULL), sq_ring(MAP_FAILED),
+    cq_ring(MAP_FAILED), sq_ring_size(0), cq_ring_size(0), to_submit(0), in_flight(0), retrying(0),
+    trigger_event(NULL)
+{
+  SET_HANDLER((DiskHandlerHandler) &DiskHandler::startAIOEvent);
+}
+
+DiskHandler::~DiskHandler()
+{
+  if (sqes)
+    munmap(sqes, sq_entries * sizeof(struct io_uring_sqe));
+  if (cq_ring != MAP_FAILED && cq_ring != sq_ring)
+    munmap(cq_ring, cq_ring_size);
+  if (sq_ring != MAP_FAILED)
+    munmap(sq_ring, sq_ring_size);
+  if (ring_fd >= 0)
+    close(ring_fd);
+}
+
+bool
+DiskHandler::init(unsigned entries, int evfd)
+{
+  struct io_uring_params p;
+
+  memset(&p, 0, sizeof(p));
+  if ((ring_fd = sys_io_uring_setup(entries, &p)) < 0) {
+    Warning("io_uring_setup(%u) failed: %d, using AIO threads", entries, errno);
+    return false;
+  }
+  fcntl(ring_fd, F_SETFD, FD_CLOEXEC);
+
+  sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+#ifdef IORING_FEAT_SINGLE_MMAP
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    if (cq_ring_size > sq_ring_size)
+      sq_ring_size = cq_ring_size;
+    cq_ring_size = sq_ring_size;
+  }
+#endif
+  sq_ring = mmap(NULL, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+  if (sq_ring == MAP_FAILED)
+    goto Lfail;
+#ifdef IORING_FEAT_SINGLE_MMAP
+  if (p.features & IORING_FEAT_SINGLE_MMAP)
+    cq_ring = sq_ring;
+  else
+#endif
+    cq_ring = mmap(NULL, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+  if (cq_ring == MAP_FAILED)
+    goto Lfail;
+  sqes = (struct io_uring_sqe *) mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                                      MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  if (sqes == (struct io_uring_sqe *) MAP_FAILED) {
+    sqes = NULL;
+    goto Lfail;
+  }
+
+  sq_entries = p.sq_entries;
+  sq_head = (unsigned *) ((char *) sq_ring + p.sq_off.head);
+  sq_tail = (unsigned *) ((char *) sq_ring + p.sq_off.tail);
+  sq_mask = (unsigned *) ((char *) sq_ring + p.sq_off.ring_mask);
+  sq_array = (unsigned *) ((char *) sq_ring + p.sq_off.array);
+  cq_head = (unsigned *) ((char *) cq_ring + p.cq_off.head);
+  cq_tail = (unsigned *) ((char *) cq_ring + p.cq_off.tail);
+  cq_mask = (unsigned *) ((char *) cq_ring + p.cq_off.ring_mask);
+  cqes = (struct io_uring_cqe *) ((char *) cq_ring + p.cq_off.cqes);
+
+  // Not fatal, completions are still picked up on the next poll.
+  if (evfd >= 0 && sys_io_uring_register(ring_fd, IORING_REGISTER_EVENTFD, &evfd, 1) < 0)
+    Warning("io_uring eventfd registration failed: %d", errno);
+
+  Debug("aio", "io_uring fd %d ready with %u entries", ring_fd, sq_entries);
+  return true;
+
+Lfail:
+  Warning("io_uring ring mapping failed: %d, using AIO threads", errno);
+  close(ring_fd);
+  ring_fd = -1;
+  return false;
+}
+
+void
+DiskHandler::prep(AIOCallbackInternal *op, struct io_uring_sqe *sqe)
+{
+  ink_aiocb_t *a = &op->aiocb;
+
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = (a->aio_lio_opcode == LIO_READ) ? IORING_OP_READ : IORING_OP_WRITE;
+  sqe->fd = a->aio_fildes;
+  // aio_result holds the bytes already transferred, for resubmitting short transfers
+  sqe->addr = (uint64_t) (uintptr_t) ((char *) a->aio_buf + op->aio_result);
+  sqe->len = (uint32_t) (a->aio_nbytes - op->aio_result);
+  sqe->off = (uint64_t) (a->aio_offset + op->aio_result);
+  sqe->user_data = (uint64_t) (uintptr_t) op;
+}
+
+/* Add op and the rest of its 'then' chain to the submission ring. Either
+   the whole chain is queued or nothing is. */
+bool
+DiskHandler::queue(AIOCallbackInternal *op)
+{
+  unsigned n = 0;
+  for (AIOCallback *cb = op; cb; cb = cb->then)
+    n++;
+
+  unsigned tail = *sq_tail;
+  if (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) + n > sq_entries) {
+    submit();
+    if (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) + n > sq_entries)
+      return false;
+  }
+  // the completion ring is twice the submission ring, never let it overflow
+  if (in_flight + retrying + to_submit + n > 2 * sq_entries)
+    return false;
+
+  op->uring_pending = n;
+  for (AIOCallbackInternal *cb = op; cb; cb = (AIOCallbackInternal *) cb->then) {
+    unsigned idx = tail & *sq_mask;
+    cb->first = op;
+    cb->aio_result = 0;
+    prep(cb, &sqes[idx]);
+    sq_array[idx] = idx;
+    tail++;
+  }
+  __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+  to_submit += n;
+
+  if (op->aiocb.aio_lio_opcode == LIO_WRITE) {
+    aio_num_write++;
+    aio_bytes_written += op->aiocb.aio_nbytes;
+  } else {
+    aio_num_read++;
+    aio_bytes_read += op->aiocb.aio_nbytes;
+  }
+  return true;
+}
+
+int
+DiskHandler::submit()
+{
+  if (!to_submit)
+    return 0;
+  int ret = sys_io_uring_enter(ring_fd, to_submit, 0, 0);
+  if (ret < 0) {
+    // EAGAIN/EBUSY: the kernel is short on resources, the sqes stay queued for the next pass
+    if (errno != EAGAIN && errno != EBUSY && errno != EINTR)
+      Warning("io_uring_enter failed: %d", errno);
+    return 0;
+  }
+  to_submit -= ret;
+  in_flight += ret;
+  return ret;
+}
+
+/* Put the ops left over by reap() back on the submission ring, in order,
+   for as long as it has room. */
+void
+DiskHandler::requeue()
+{
+  AIOCallbackInternal *op;
+  while ((op = (AIOCallbackInternal *) retry.head)) {
+    unsigned stail = *sq_tail;
+    if (stail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries) {
+      submit();
+      if (stail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries)
+        return;
+    }
+    retry.dequeue();
+    retrying--;
+    unsigned idx = stail & *sq_mask;
+    prep(op, &sqes[idx]);
+    sq_array[idx] = idx;
+    __atomic_store_n(sq_tail, stail + 1, __ATOMIC_RELEASE);
+    to_submit++;
+  }
+}
+
+void
+DiskHandler::reap()
+{
+  EThread *t = trigger_event->ethread;
+  Que(AIOCallback, link) done;
+  unsigned head = *cq_head;
+  unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+
+  for (; head != tail; head++) {
+    struct io_uring_cqe *cqe = &cqes[head & *cq_mask];
+    AIOCallbackInternal *op = (AIOCallbackInternal *) (uintptr_t) cqe->user_data;
+    ink_aiocb_t *a = &op->aiocb;
+    int res = cqe->res;
+
+    in_flight--;
+    if (res == -EINTR || res == -EAGAIN || (res > 0 && op->aio_result + res < (int64_t) a->aio_nbytes)) {
+      if (res > 0)
+        op->aio_result += res;
+      // keep the partial result, requeue() puts it back once an sqe is free
+      retry.enqueue(op);
+      retrying++;
+      continue;
+    }
+    if (res <= 0) {
+      Warning("cache disk operation failed %s %d %d\n", (a->aio_lio_opcode == LIO_READ) ? "READ" : "WRITE", res, -res);
+      op->aio_result = res ? res : -EIO;
+      if (aio_err_callbck) {
+        AIOCallback *callback_op = new AIOCallbackInternal();
+        callback_op->aiocb.aio_fildes = a->aio_fildes;
+        callback_op->action = aio_err_callbck;
+        eventProcessor.schedule_imm(callback_op);
+      }
+    } else
+      op->aio_result += res;
+    if (!--((AIOCallbackInternal *) op->first)->uring_pending)
+      done.enqueue(op->first);
+  }
+  __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+  // Callbacks may queue new operations on this ring, so only run them
+  // once the completion ring has been consumed.
+  AIOCallback *op;
+  while ((op = done.dequeue())) {
+    op->mutex = op->action.mutex;
+    if (op->thread == AIO_CALLBACK_THREAD_ANY || op->thread == AIO_CALLBACK_THREAD_AIO || op->thread == t) {
+      MUTEX_TRY_LOCK(lock, op->mutex, t);
+      if (!lock)
+        t->schedule_imm_local(op);
+      else if (!op->action.cancelled)
+        op->action.continuation->handleEvent(AIO_EVENT_DONE, op);
+    } else
+      op->thread->schedule_imm_signal(op);
+  }
+}
+
+int
+DiskHandler::startAIOEvent(int event, Event *e)
+{
+  (void) event;
+  SET_HANDLER((DiskHandlerHandler) &DiskHandler::mainAIOEvent);
+  e->schedule_every(AIO_PERIOD);
+  trigger_event = e;
+  return EVENT_CONT;
+}
+
+int
+DiskHandler::mainAIOEvent(int event, Event *e)
+{
+  ink_assert(trigger_event == e && (event == EVENT_INTERVAL || event == EVENT_POLL));
+  (void) event;
+  (void) e;
+  requeue();
+  submit();
+  if (in_flight)
+    reap();
+  // pick up the retries and anything queued by the completion callbacks
+  requeue();
+  submit();
+  return EVENT_CONT;
+}
+
+static volatile bool aio_uring_failed = false;
+
+/* Queue op on the ring of the calling thread, creating the ring on first
+   use. Only threads with an async signal poll (the net threads) get one,
+   as the DiskHandler relies on the NetHandler to block between passes. */
+static bool
+aio_uring_queue(AIOCallbackInternal *op)
+{
+  EThread *t = this_ethread();
+
+  if (cache_config_io_uring_entries <= 0 || aio_uring_failed || !t || t->tt != REGULAR || !t->ep)
+    return false;
+  DiskHandler *dh = t->diskHandler;
+  if (!dh) {
+    dh = NEW(new DiskHandler);
+#if TS_HAS_EVENTFD
+    int evfd = t->evfd;
+#else
+    int evfd = -1;
+#endif
+    if (!dh->init((unsigned) cache_config_io_uring_entries, evfd)) {
+      // the other threads would fail the same way, use the AIO threads everywhere
+      delete dh;
+      aio_uring_failed = true;
+      return false;
+    }
+    t->diskHandler = dh;
+    t->schedule_imm_local(dh);
+  }
+  return dh->queue(op);
+}
+#endif
+
 int
 ink_aio_read(AIOCallback *op, int fromAPI)
 {
@@ -434,6 +765,9 @@ ink_aio_read(AIOCallback *op, int fromAPI)
   op->action.continuation->handleEvent(AIO_EVENT_DONE, op);
 #elif (AIO_MODE == AIO_MODE_THREAD)
   aio_queue_req((AIOCallbackInternal *) op, fromAPI);
+#elif (AIO_MODE == AIO_MODE_IO_URING)
+  if (fromAPI || !aio_uring_queue((AIOCallbackInternal *) op))
+    aio_queue_req((AIOCallbackInternal *) op, fromAPI);
 #endif
 
   return 1;
@@ -457,6 +791,9 @@ ink_aio_write(AIOCallback *op, int fromAPI)
   op->action.continuation->handleEvent(AIO_EVENT_DONE, op);
 #elif (AIO_MODE == AIO_MODE_THREAD)
   aio_queue_req((AIOCallbackInternal *) op, fromAPI);
+#elif (AIO_MODE == AIO_MODE_IO_URING)
+  if (fromAPI || !aio_uring_queue((AIOCallbackInternal *) op))
+    aio_queue_req((AIOCallbackInternal *) op, fromAPI);
 #endif
 
   return 1;
@@ -50,7 +50,12 @@
 #define AIO_MODE_AIO             0
 #define AIO_MODE_SYNC            1
 #define AIO_MODE_THREAD          2
+#define AIO_MODE_IO_URING        3
+#if TS_USE_IO_URING
+#define AIO_MODE                 AIO_MODE_IO_URING
+#else
 #define AIO_MODE                 AIO_MODE_THREAD
+#endif
 
 // AIOCallback::thread special values
 #define AIO_CALLBACK_THREAD_ANY ((EThread*)0) // any regular event thread
@@ -53,6 +53,9 @@ struct AIOCallbackInternal: public AIOCallback
   AIOCallback *first;
   AIO_Reqs *aio_req;
   ink_hrtime sleep_time;
+#if (AIO_MODE == AIO_MODE_IO_URING)
+  int uring_pending;            /* ops of this chain still in the ring */
+#endif
   int io_complete(int event, void *data);
   AIOCallbackInternal()
   {
@@ -97,6 +100,56 @@ struct AIO_Reqs
   volatile int requests_queued;
 };
 
+#if (AIO_MODE == AIO_MODE_IO_URING)
+#include <linux/io_uring.h>
+
+// Run just ahead of the NetHandler poll (NET_PERIOD) so queued operations
+// are submitted before the thread blocks in epoll_wait.
+#define AIO_PERIOD               -HRTIME_MSECONDS(4)
+
+/* Per EThread io_uring instance. Operations are queued into the
+   submission ring by ink_aio_read/ink_aio_write on the owning thread and
+   handed to the kernel in one io_uring_enter per event loop iteration,
+   completions are reaped on the same pass. The thread's eventfd is
+   registered with the ring, so a completion wakes up the poll. */
+struct DiskHandler: public Continuation
+{
+  int ring_fd;
+  unsigned *sq_head;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  unsigned sq_entries;
+  struct io_uring_sqe *sqes;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  struct io_uring_cqe *cqes;
+  void *sq_ring;
+  void *cq_ring;
+  size_t sq_ring_size;
+  size_t cq_ring_size;
+  unsigned to_submit;           /* sqes queued since the last io_uring_enter */
+  int in_flight;                /* sqes handed to the kernel, not yet reaped */
+  Que(AIOCallback, link) retry; /* short or EAGAIN completions waiting to be resubmitted */
+  int retrying;                 /* ops on retry */
+  Event *trigger_event;
+
+  bool init(unsigned entries, int evfd);
+  bool queue(AIOCallbackInternal *op);
+  void prep(AIOCallbackInternal *op, struct io_uring_sqe *sqe);
+  int submit();
+  void requeue();
+  void reap();
+  int startAIOEvent(int event, Event *e);
+  int mainAIOEvent(int event, Event *e);
+
+  DiskHandler();
+  ~DiskHandler();
+};
+typedef int (DiskHandler::*DiskHandlerHandler) (int, void *);
+#endif
+
 #ifdef AIO_STATS
 class AIOTestData:public Continuation
 {
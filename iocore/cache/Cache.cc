@@ -56,6 +56,10 @@ int64_t cache_config_ram_cache_size = AUTO_SIZE_RAM_CACHE;
 int cache_config_ram_cache_algorithm = 0;
 int cache_config_ram_cache_compress = 0;
 int cache_config_ram_cache_compress_percent = 90;
+int cache_config_ram_cache_shards = 0;
+int cache_config_ram_cache_compress_cpu_percent = 100;
+int cache_config_admission_threshold = 0;
+int cache_config_admission_window = 0;
 int cache_config_http_max_alts = 3;
 int cache_config_dir_sync_frequency = 60;
 int cache_config_permit_pinning = 0;
@@ -72,11 +76,14 @@ int cache_config_hit_evacuate_size_limit = 0;
 int cache_config_force_sector_size = 0;
 int cache_config_target_fragment_size = DEFAULT_TARGET_FRAGMENT_SIZE;
 int cache_config_agg_write_backlog = AGG_SIZE * 2;
+int cache_config_agg_write_size = AGG_SIZE;
 int cache_config_enable_checksum = 0;
 int cache_config_alt_rewrite_max_size = 4096;
 int cache_config_read_while_writer = 0;
 char cache_system_config_directory[PATH_NAME_MAX + 1];
 int cache_config_mutex_retry_delay = 2;
+int cache_config_read_ahead_fragments = 0;
+int cache_config_read_ahead_max_pending = 32;
 
 // Globals
 
@@ -100,6 +107,7 @@ CacheProcessor cacheProcessor;
 Vol **gvol = NULL;
 volatile int gnvol = 0;
 ClassAllocator<CacheVC> cacheVConnectionAllocator("cacheVConnection");
+ClassAllocator<CacheReadAhead> cacheReadAheadAllocator("cacheReadAhead");
 ClassAllocator<EvacuationBlock> evacuationBlockAllocator("evacuationBlock");
 ClassAllocator<CacheRemoveCont> cacheRemoveContAllocator("cacheRemoveCont");
 ClassAllocator<EvacuationKey> evacuationKeyAllocator("evacuationKey");
@@ -180,7 +188,7 @@ cache_bytes_used(int volume)
       if (!gvol[i]->header->cycle)
           used += gvol[i]->header->write_pos - gvol[i]->start;
       else
-          used += gvol[i]->len - vol_dirlen(gvol[i]) - EVACUATION_SIZE;
+          used += gvol[i]->len - vol_dirlen(gvol[i]) - vol_evacuation_size(gvol[i]);
     }
   }
   return used;
@@ -664,6 +672,10 @@ CacheProcessor::diskInitialized()
         char vol_stat_str_prefix[256];
         snprintf(vol_stat_str_prefix, sizeof(vol_stat_str_prefix), "proxy.process.cache.volume_%d", cp->vol_number);
         register_cache_stats(cp->vol_rsb, vol_stat_str_prefix);
+        if (cache_config_ram_cache_shards) {
+          cp->ram_cache_shard_rsb = RecAllocateRawStatBlock(cache_config_ram_cache_shards * ram_cache_shard_stat_count);
+          register_ram_cache_shard_stats(cp->ram_cache_shard_rsb, vol_stat_str_prefix, cache_config_ram_cache_shards);
+        }
       }
     }
 
@@ -768,17 +780,11 @@ CacheProcessor::cacheInitialized()
           (unsigned int) caches_ready, gnvol);
     int64_t ram_cache_bytes = 0;
     if (gnvol) {
-      for (i = 0; i < gnvol; i++) {
-        switch (cache_config_ram_cache_algorithm) {
-          default:
-          case RAM_CACHE_ALGORITHM_CLFUS:
-            gvol[i]->ram_cache = new_RamCacheCLFUS();
-            break;
-          case RAM_CACHE_ALGORITHM_LRU:
-            gvol[i]->ram_cache = new_RamCacheLRU();
-            break;
-        }
-      }
+      // the RAM cache is used without the vol lock, so even unsharded
+      // it is a single shard with its own lock
+      for (i = 0; i < gnvol; i++)
+        gvol[i]->ram_cache = new_RamCacheSharded(cache_config_ram_cache_algorithm,
+                                                 cache_config_ram_cache_shards ? cache_config_ram_cache_shards : 1);
       if (cache_config_ram_cache_size == AUTO_SIZE_RAM_CACHE) {
         Debug("cache_init", "CacheProcessor::cacheInitialized - cache_config_ram_cache_size == AUTO_SIZE_RAM_CACHE");
         for (i = 0; i < gnvol; i++) {
@@ -984,6 +990,8 @@ void
 vol_clear_init(Vol *d)
 {
   size_t dir_len = vol_dirlen(d);
+  for (int s = 0; s < d->segments; s++)
+    dir_segment_dirty(s, d);
   memset(d->raw_dir, 0, dir_len);
   vol_init_dir(d);
   d->header->magic = VOL_MAGIC;
@@ -1062,10 +1070,30 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
   evacuate = (DLL<EvacuationBlock> *)ats_malloc(evac_len);
   memset(evacuate, 0, evac_len);
 
-  raw_dir = (char *)ats_memalign(sysconf(_SC_PAGESIZE), vol_dirlen(this));
+  agg_size = cache_config_agg_write_size;
+#if defined(_WIN32)
+  agg_buffer = (char *)ats_malloc(agg_size);
+  agg_flush_buffer = (char *)ats_malloc(agg_size);
+#else
+  agg_buffer = (char *)ats_memalign(sysconf(_SC_PAGESIZE), agg_size);
+  agg_flush_buffer = (char *)ats_memalign(sysconf(_SC_PAGESIZE), agg_size);
+#endif
+  memset(agg_buffer, 0, agg_size);
+  memset(agg_flush_buffer, 0, agg_size);
+
+  // the directory lives as long as the process, so a huge page mapping
+  // which is never unmapped is fine and saves TLB misses on dir_probe()
+  raw_dir = (char *)ats_alloc_hugepage(vol_dirlen(this));
+  if (!raw_dir)
+    raw_dir = (char *)ats_memalign(sysconf(_SC_PAGESIZE), vol_dirlen(this));
   dir = (Dir *) (raw_dir + vol_headerlen(this));
   header = (VolHeaderFooter *) raw_dir;
   footer = (VolHeaderFooter *) (raw_dir + vol_dirlen(this) - ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter)));
+  if (cache_config_admission_threshold > 1)
+    admission.init((int64_t) buckets * segments * DIR_DEPTH, cache_config_admission_window);
+  // nothing is known about what is on disk, write every segment to both copies
+  dir_sync_state = (uint8_t *)ats_malloc(segments);
+  memset(dir_sync_state, DIR_SYNC_DIRTY(0) | DIR_SYNC_DIRTY(1), segments);
 
   if (clear) {
     Note("clearing cache directory '%s'", hash_id);
@@ -1212,8 +1240,12 @@ Vol::handle_recover_from_data(int event, void *data)
       recover_wrapped = 1;
       recover_pos = start;
     }
-    io.aiocb.aio_buf = (char *)ats_memalign(sysconf(_SC_PAGESIZE), RECOVERY_SIZE);
-    io.aiocb.aio_nbytes = RECOVERY_SIZE;
+    // the last write may have been made with a larger agg_write_size
+    size_t recovery_size = vol_evacuation_size(this);
+    if ((size_t) (header->write_pos - header->last_write_pos) >= recovery_size)
+      recovery_size = ROUND_TO_STORE_BLOCK(header->write_pos - header->last_write_pos) + agg_size;
+    io.aiocb.aio_buf = (char *)ats_memalign(sysconf(_SC_PAGESIZE), recovery_size);
+    io.aiocb.aio_nbytes = recovery_size;
     if ((off_t)(recover_pos + io.aiocb.aio_nbytes) > (off_t)(skip + len))
       io.aiocb.aio_nbytes = (skip + len) - recover_pos;
   } else if (event == AIO_EVENT_DONE) {
@@ -1263,7 +1295,7 @@ Vol::handle_recover_from_data(int event, void *data)
     if (recover_wrapped && start == io.aiocb.aio_offset) {
       doc = (Doc *) s;
       if (doc->magic != DOC_MAGIC || doc->write_serial < last_write_serial) {
-        recover_pos = skip + len - EVACUATION_SIZE;
+        recover_pos = skip + len - vol_evacuation_size(this);
         goto Ldone;
       }
     }
@@ -1291,7 +1323,7 @@ Vol::handle_recover_from_data(int event, void *data)
              sync serial and less than (header->sync_serial + 2) then
              continue;
 
-             3. If the position we are recovering from is within AGG_SIZE
+             3. If the position we are recovering from is within agg_size
              from the disk end, then we can't trust this document. The
              aggregation buffer might have been larger than the remaining space
              at the end and we decided to wrap around instead of writing
@@ -1313,10 +1345,10 @@ Vol::handle_recover_from_data(int event, void *data)
           // (doc->sync_serial < last_sync_serial) ||
           // (doc->sync_serial > header->sync_serial + 1).
           // if we are too close to the end, wrap around
-          else if (recover_pos - (e - s) > (skip + len) - AGG_SIZE) {
+          else if (recover_pos - (e - s) > (skip + len) - agg_size) {
             recover_wrapped = 1;
             recover_pos = start;
-            io.aiocb.aio_nbytes = RECOVERY_SIZE;
+            io.aiocb.aio_nbytes = vol_evacuation_size(this);
 
             break;
           }
@@ -1325,13 +1357,13 @@ Vol::handle_recover_from_data(int event, void *data)
           goto Ldone;
         } else {
           // doc->magic != DOC_MAGIC
-          // If we are in the danger zone - recover_pos is within AGG_SIZE
+          // If we are in the danger zone - recover_pos is within agg_size
           // from the end, then wrap around
           recover_pos -= e - s;
-          if (recover_pos > (skip + len) - AGG_SIZE) {
+          if (recover_pos > (skip + len) - agg_size) {
             recover_wrapped = 1;
             recover_pos = start;
-            io.aiocb.aio_nbytes = RECOVERY_SIZE;
+            io.aiocb.aio_nbytes = vol_evacuation_size(this);
 
             break;
           }
@@ -1344,7 +1376,7 @@ Vol::handle_recover_from_data(int event, void *data)
       s += round_to_approx_size(doc->len);
     }
 
-    /* if (s > e) then we gone through RECOVERY_SIZE; we need to
+    /* if (s > e) then we gone through the buffer; we need to
        read more data off disk and continue recovering */
     if (s >= e) {
       /* In the last iteration, we increment s by doc->len...need to undo
@@ -1354,7 +1386,7 @@ Vol::handle_recover_from_data(int event, void *data)
       recover_pos -= e - s;
       if (recover_pos >= skip + len)
         recover_pos = start;
-      io.aiocb.aio_nbytes = RECOVERY_SIZE;
+      io.aiocb.aio_nbytes = vol_evacuation_size(this);
       if ((off_t)(recover_pos + io.aiocb.aio_nbytes) > (off_t)(skip + len))
         io.aiocb.aio_nbytes = (skip + len) - recover_pos;
     }
@@ -1375,8 +1407,8 @@ Ldone:{
       return handle_recover_write_dir(EVENT_IMMEDIATE, 0);
     }
 
-    recover_pos += EVACUATION_SIZE;   // safely cover the max write size
-    if (recover_pos < header->write_pos && (recover_pos + EVACUATION_SIZE >= header->write_pos)) {
+    recover_pos += vol_evacuation_size(this);   // safely cover the max write size
+    if (recover_pos < header->write_pos && (recover_pos + vol_evacuation_size(this) >= header->write_pos)) {
       Debug("cache_init", "Head Pos: %" PRIu64 ", Rec Pos: %" PRIu64 ", Wrapped:%d", header->write_pos, recover_pos, recover_wrapped);
       Warning("no valid directory found while recovering '%s', clearing", hash_id);
       goto Lclear;
@@ -1839,6 +1871,9 @@ CacheVC::handleReadDone(int event, Event *e)
   else
     if (is_io_in_progress())
       return EVENT_CONT;
+  // the ram cache put is made after the vol lock is released
+  int okay = 0;
+  bool ram_put = false, http_copy_hdr = false;
   {
     MUTEX_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
     if (!lock)
@@ -1868,7 +1903,7 @@ CacheVC::handleReadDone(int event, Event *e)
     // put into ram cache?
     if (io.ok() &&
         ((doc->first_key == *read_key) || (doc->key == *read_key) || STORE_COLLISION) && doc->magic == DOC_MAGIC) {
-      int okay = 1;
+      okay = 1;
       if (!f.doc_from_ram_cache)
         f.not_from_ram_cache = 1;
       if (cache_config_enable_checksum && doc->checksum != DOC_NO_CHECKSUM) {
@@ -1885,7 +1920,6 @@ CacheVC::handleReadDone(int event, Event *e)
           okay = 0;
         }
       }
-      bool http_copy_hdr = false;
 #ifdef HTTP_CACHE
       http_copy_hdr = cache_config_ram_cache_compress && !f.doc_from_ram_cache &&
         doc->ftype == CACHE_FRAG_TYPE_HTTP && doc->hlen;
@@ -1906,11 +1940,9 @@ CacheVC::handleReadDone(int event, Event *e)
         cutoff_check = ((!doc_len && (int64_t)doc->total_len < cache_config_ram_cache_cutoff)
                         || (doc_len && (int64_t)doc_len < cache_config_ram_cache_cutoff)
                         || !cache_config_ram_cache_cutoff);
-        if (cutoff_check && !f.doc_from_ram_cache) {
-          uint64_t o = dir_offset(&dir);
-          vol->ram_cache->put(read_key, buf, doc->len, http_copy_hdr, (uint32_t)(o >> 32), (uint32_t)o);
-        }
-        if (!doc_len) {
+        ram_put = cutoff_check && !f.doc_from_ram_cache;
+        // a buffer still to be unmarshalled is kept to ourselves until then
+        if (!doc_len && !http_copy_hdr) {
           // keep a pointer to it. In case the state machine decides to
           // update this document, we don't have to read it back in memory
           // again
@@ -1919,13 +1951,26 @@ CacheVC::handleReadDone(int event, Event *e)
           vol->first_fragment_data = buf;
         }
       }                           // end VIO::READ check
-#ifdef HTTP_CACHE
-      // If it could be compressed, unmarshal after
-      if (http_copy_hdr && doc->ftype == CACHE_FRAG_TYPE_HTTP && doc->hlen && okay)
-        unmarshal_helper(doc, buf, okay);
-#endif
     }                             // end io.ok() check
   }
+  if (ram_put) {
+    uint64_t o = dir_offset(&dir);
+    vol->ram_cache->put(read_key, buf, ((Doc *) buf->data())->len, http_copy_hdr, (uint32_t)(o >> 32), (uint32_t)o);
+  }
+#ifdef HTTP_CACHE
+  // If it could be compressed, unmarshal after
+  if (http_copy_hdr && okay) {
+    unmarshal_helper((Doc *) buf->data(), buf, okay);
+    if (okay && vio.op == VIO::READ && !doc_len) {
+      MUTEX_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+      if (lock) {
+        vol->first_fragment_key = *read_key;
+        vol->first_fragment_offset = dir_offset(&dir);
+        vol->first_fragment_data = buf;
+      }
+    }
+  }
+#endif
 Ldone:
   POP_HANDLER;
   return handleEvent(AIO_EVENT_DONE, 0);
@@ -1941,10 +1986,29 @@ CacheVC::handleRead(int event, Event *e)
 
   f.doc_from_ram_cache = false;
 
-  // check ram cache
   ink_debug_assert(vol->mutex->thread_holding == this_ethread());
-  if (vol->ram_cache->get(read_key, &buf, 0, dir_offset(&dir)))
-    goto LramHit;
+
+  // check if it was read ahead
+  if (read_ahead_list && *read_key == read_ahead_list->key &&
+      dir_offset(&dir) == dir_offset(&read_ahead_list->dir)) {
+    CacheReadAhead *ra = read_ahead_list;
+    read_ahead_list = ra->next;
+    ra->next = NULL;
+    CACHE_INCREMENT_DYN_STAT(cache_read_ahead_hits_stat);
+    SET_HANDLER(&CacheVC::handleReadDone);
+    if (!ra->done) {
+      // wait for it, CacheReadAhead::readDone calls us back
+      read_ahead_wait = ra;
+      io.aiocb.aio_fildes = vol->fd;
+      return EVENT_CONT;
+    }
+    io.aiocb.aio_offset = ra->io.aiocb.aio_offset;
+    io.aiocb.aio_nbytes = ra->io.aiocb.aio_nbytes;
+    io.aio_result = ra->io.aio_result;
+    buf = ra->buf;
+    free_CacheReadAhead(ra);
+    return EVENT_RETURN;
+  }
 
   // check if it was read in the last open_read call
   if (*read_key == vol->first_fragment_key && dir_offset(&dir) == vol->first_fragment_offset) {
@@ -1956,9 +2020,17 @@ CacheVC::handleRead(int event, Event *e)
   if (dir_agg_buf_valid(vol, &dir)) {
     int agg_offset = vol_offset(vol, &dir) - vol->header->write_pos;
     buf = new_IOBufferData(iobuffer_size_to_index(io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
-    ink_assert((agg_offset + io.aiocb.aio_nbytes) <= (unsigned) vol->agg_buf_pos);
     char *doc = buf->data();
-    char *agg = vol->agg_buffer + agg_offset;
+    char *agg;
+    // the first agg_flush_len bytes are in the buffer being written
+    if (agg_offset < vol->agg_flush_len) {
+      ink_assert((agg_offset + io.aiocb.aio_nbytes) <= (unsigned) vol->agg_flush_len);
+      agg = vol->agg_flush_buffer + agg_offset;
+    } else {
+      agg_offset -= vol->agg_flush_len;
+      ink_assert((agg_offset + io.aiocb.aio_nbytes) <= (unsigned) vol->agg_buf_pos);
+      agg = vol->agg_buffer + agg_offset;
+    }
     memcpy(doc, agg, io.aiocb.aio_nbytes);
     io.aio_result = io.aiocb.aio_nbytes;
     SET_HANDLER(&CacheVC::handleReadDone);
@@ -1969,28 +2041,45 @@ CacheVC::handleRead(int event, Event *e)
   io.aiocb.aio_offset = vol_offset(vol, &dir);
   if ((off_t)(io.aiocb.aio_offset + io.aiocb.aio_nbytes) > (off_t)(vol->skip + vol->len))
     io.aiocb.aio_nbytes = vol->skip + vol->len - io.aiocb.aio_offset;
-  buf = new_IOBufferData(iobuffer_size_to_index(io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
-  io.aiocb.aio_buf = buf->data();
-  io.action = this;
-  io.thread = mutex->thread_holding->tt == DEDICATED ? AIO_CALLBACK_THREAD_ANY : mutex->thread_holding;
-  SET_HANDLER(&CacheVC::handleReadDone);
-  ink_assert(ink_aio_read(&io) >= 0);
-  CACHE_DEBUG_INCREMENT_DYN_STAT(cache_pread_count_stat);
-  return EVENT_CONT;
+  // the ram cache and the disk are tried with our copy of the dir once
+  // the caller has released the volume lock
+  SET_HANDLER(&CacheVC::handleReadRamCache);
+  return EVENT_RETURN;
+
+LmemHit:
+  io.aio_result = io.aiocb.aio_nbytes;
+  POP_HANDLER;
+  return EVENT_RETURN; // allow the caller to release the volume lock
+}
+
+int
+CacheVC::handleReadRamCache(int event, Event *e)
+{
+  NOWARN_UNUSED(event);
+  NOWARN_UNUSED(e);
+  cancel_trigger();
 
-LramHit: {
+  // check ram cache, its shards have their own locks
+  if (vol->ram_cache->get(read_key, &buf, 0, dir_offset(&dir))) {
     io.aio_result = io.aiocb.aio_nbytes;
     Doc *doc = (Doc*)buf->data();
     if (cache_config_ram_cache_compress && doc->ftype == CACHE_FRAG_TYPE_HTTP && doc->hlen) {
       SET_HANDLER(&CacheVC::handleReadDone);
       f.doc_from_ram_cache = true;
-      return EVENT_RETURN;
+      return handleEvent(AIO_EVENT_DONE, 0);
     }
+    POP_HANDLER;
+    return handleEvent(AIO_EVENT_DONE, 0);
   }
-LmemHit:
-  io.aio_result = io.aiocb.aio_nbytes;
-  POP_HANDLER;
-  return EVENT_RETURN; // allow the caller to release the volume lock
+
+  buf = new_IOBufferData(iobuffer_size_to_index(io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
+  io.aiocb.aio_buf = buf->data();
+  io.action = this;
+  io.thread = mutex->thread_holding->tt == DEDICATED ? AIO_CALLBACK_THREAD_ANY : mutex->thread_holding;
+  SET_HANDLER(&CacheVC::handleReadDone);
+  ink_assert(ink_aio_read(&io) >= 0);
+  CACHE_DEBUG_INCREMENT_DYN_STAT(cache_pread_count_stat);
+  return EVENT_CONT;
 }
 
 Action *
@@ -2063,7 +2152,6 @@ CacheVC::removeEvent(int event, Event *e)
       }
       f.remove_aborted_writers = 1;
     }
-  Lread:
     if (!buf)
       goto Lcollision;
     if (!dir_valid(vol, &dir)) {
@@ -2093,7 +2181,7 @@ CacheVC::removeEvent(int event, Event *e)
     if (dir_probe(&key, vol, &dir, &last_collision) > 0) {
       int ret = do_read_call(&key);
       if (ret == EVENT_RETURN)
-        goto Lread;
+        goto Lcallreturn;
       return ret;
     }
   Ldone:
@@ -2108,6 +2196,8 @@ Lremoved:
   _action.continuation->handleEvent(CACHE_EVENT_REMOVE, 0);
 Lfree:
   return free_CacheVC(this);
+Lcallreturn:
+  return handleEvent(AIO_EVENT_DONE, 0); // hopefully a tail call
 }
 
 Action *
@@ -2617,6 +2707,18 @@ register_cache_stats(RecRawStatBlock *rsb, const char *prefix)
   REG_INT("hdr_marshal_bytes", cache_hdr_marshal_bytes_stat);
   REG_INT("gc_bytes_evacuated", cache_gc_bytes_evacuated_stat);
   REG_INT("gc_frags_evacuated", cache_gc_frags_evacuated_stat);
+  REG_INT("read_ahead.issued", cache_read_ahead_issued_stat);
+  REG_INT("read_ahead.hits", cache_read_ahead_hits_stat);
+  REG_INT("read_ahead.wasted", cache_read_ahead_wasted_stat);
+  REG_INT("ram_cache.compress.bytes_in", cache_ram_cache_compress_bytes_in_stat);
+  REG_INT("ram_cache.compress.bytes_saved", cache_ram_cache_compress_bytes_saved_stat);
+  // average compressed size in percent of the original
+  reg_int("ram_cache.compress.ratio", cache_ram_cache_compress_ratio_stat, rsb, prefix, RecRawStatSyncAvg);
+  snprintf(stat_str, sizeof(stat_str), "%s.%s", prefix, "ram_cache.decompress_time");
+  RecRegisterRawStat(rsb, RECT_PROCESS, stat_str, RECD_FLOAT, RECP_NON_PERSISTENT,
+                     (int) cache_ram_cache_decompress_time_stat, RecRawStatSyncHrTimeAvg);
+  REG_INT("admission.admitted", cache_admission_admitted_stat);
+  REG_INT("admission.rejected", cache_admission_rejected_stat);
 }
 
 
@@ -2634,6 +2736,18 @@ ink_cache_init(ModuleVersion v)
   IOCORE_EstablishStaticConfigInt32(cache_config_ram_cache_algorithm, "proxy.config.cache.ram_cache.algorithm");
   IOCORE_EstablishStaticConfigInt32(cache_config_ram_cache_compress, "proxy.config.cache.ram_cache.compress");
   IOCORE_EstablishStaticConfigInt32(cache_config_ram_cache_compress_percent, "proxy.config.cache.ram_cache.compress_percent");
+  IOCORE_EstablishStaticConfigInt32(cache_config_ram_cache_compress_cpu_percent, "proxy.config.cache.ram_cache.compress_cpu_percent");
+  Debug("cache_init", "proxy.config.cache.ram_cache.compress_cpu_percent = %d", cache_config_ram_cache_compress_cpu_percent);
+  IOCORE_EstablishStaticConfigInt32(cache_config_admission_threshold, "proxy.config.cache.admission.threshold");
+  Debug("cache_init", "proxy.config.cache.admission.threshold = %d", cache_config_admission_threshold);
+  IOCORE_EstablishStaticConfigInt32(cache_config_admission_window, "proxy.config.cache.admission.window");
+  Debug("cache_init", "proxy.config.cache.admission.window = %d", cache_config_admission_window);
+  IOCORE_EstablishStaticConfigInt32(cache_config_ram_cache_shards, "proxy.config.cache.ram_cache.shards");
+  if (cache_config_ram_cache_shards < 0)
+    cache_config_ram_cache_shards = 0;
+  if (cache_config_ram_cache_shards > RAM_CACHE_MAX_SHARDS)
+    cache_config_ram_cache_shards = RAM_CACHE_MAX_SHARDS;
+  Debug("cache_init", "proxy.config.cache.ram_cache.shards = %d", cache_config_ram_cache_shards);
 
   IOCORE_EstablishStaticConfigInt32(cache_config_http_max_alts, "proxy.config.cache.limits.http.max_alts");
   Debug("cache_init", "proxy.config.cache.limits.http.max_alts = %d", cache_config_http_max_alts);
@@ -2661,6 +2775,11 @@ ink_cache_init(ModuleVersion v)
   IOCORE_EstablishStaticConfigInt32(cache_config_mutex_retry_delay, "proxy.config.cache.mutex_retry_delay");
   Debug("cache_init", "proxy.config.cache.mutex_retry_delay = %dms", cache_config_mutex_retry_delay);
 
+  IOCORE_EstablishStaticConfigInt32(cache_config_read_ahead_fragments, "proxy.config.cache.read_ahead.fragments");
+  Debug("cache_init", "proxy.config.cache.read_ahead.fragments = %d", cache_config_read_ahead_fragments);
+  IOCORE_EstablishStaticConfigInt32(cache_config_read_ahead_max_pending, "proxy.config.cache.read_ahead.max_pending");
+  Debug("cache_init", "proxy.config.cache.read_ahead.max_pending = %d", cache_config_read_ahead_max_pending);
+
   // This is just here to make sure IOCORE "standalone" works, it's usually configured in RecordsConfig.cc
   IOCORE_RegisterConfigString(RECT_CONFIG, "proxy.config.config_dir", TS_BUILD_SYSCONFDIR, RECU_DYNAMIC, RECC_NULL, NULL);
   IOCORE_ReadConfigString(cache_system_config_directory, "proxy.config.config_dir", PATH_NAME_MAX);
@@ -2710,6 +2829,14 @@ ink_cache_init(ModuleVersion v)
   IOCORE_EstablishStaticConfigInt32(cache_config_agg_write_backlog, "proxy.config.cache.agg_write_backlog");
   Debug("cache_init", "proxy.config.cache.agg_write_backlog = %d", cache_config_agg_write_backlog);
 
+  IOCORE_EstablishStaticConfigInt32(cache_config_agg_write_size, "proxy.config.cache.agg_write_size");
+  if (cache_config_agg_write_size < AGG_SIZE)
+    cache_config_agg_write_size = AGG_SIZE;
+  if (cache_config_agg_write_size > MAX_AGG_SIZE)
+    cache_config_agg_write_size = MAX_AGG_SIZE;
+  cache_config_agg_write_size = ROUND_TO_STORE_BLOCK(cache_config_agg_write_size);
+  Debug("cache_init", "proxy.config.cache.agg_write_size = %d", cache_config_agg_write_size);
+
   IOCORE_EstablishStaticConfigInt32(cache_config_enable_checksum, "proxy.config.cache.enable_checksum");
   Debug("cache_init", "proxy.config.cache.enable_checksum = %d", cache_config_enable_checksum);
 
@@ -201,11 +201,34 @@ dir_bucket_loop_check(Dir *start_dir, Dir *seg)
   return 1;
 }
 
+// copy segment s into the sync buffer if the sync in progress
+// will write it and it has not been copied yet
+static inline void
+dir_segment_snap(int s, Vol *d)
+{
+  uint8_t st = d->dir_sync_state[s];
+  if ((st & (DIR_SYNC_SNAP | DIR_SYNC_COPIED)) == DIR_SYNC_SNAP) {
+    size_t o = (char *) dir_segment(s, d) - d->raw_dir;
+    memcpy(d->dir_sync_buf + o, d->raw_dir + o, d->buckets * DIR_DEPTH * SIZEOF_DIR);
+    d->dir_sync_state[s] = st | DIR_SYNC_COPIED;
+  }
+}
+
+// must be called before segment s is changed so that the sync
+// in progress writes the segment as it was when the sync started
+void
+dir_segment_dirty(int s, Vol *d)
+{
+  dir_segment_snap(s, d);
+  d->dir_sync_state[s] |= DIR_SYNC_DIRTY(0) | DIR_SYNC_DIRTY(1);
+}
+
 // adds all the directory entries
 // in a segment to the segment freelist
 void
 dir_init_segment(int s, Vol *d)
 {
+  dir_segment_dirty(s, d);
   d->header->freelist[s] = 0;
   Dir *seg = dir_segment(s, d);
   int l, b;
@@ -287,6 +310,7 @@ inline void
 unlink_from_freelist(Dir *e, int s, Vol *d)
 {
   Dir *seg = dir_segment(s, d);
+  dir_segment_dirty(s, d);
   Dir *p = dir_from_offset(dir_prev(e), seg);
   if (p)
     dir_set_next(p, dir_next(e));
@@ -302,6 +326,7 @@ dir_delete_entry(Dir *e, Dir *p, int s, Vol *d)
 {
   Dir *seg = dir_segment(s, d);
   int no = dir_next(e);
+  dir_segment_dirty(s, d);
   d->header->dirty = 1;
   if (p) {
     unsigned int fo = d->header->freelist[s];
@@ -380,6 +405,7 @@ dir_clear_range(off_t start, off_t end, Vol *vol)
   for (int i = 0; i < vol->buckets * DIR_DEPTH * vol->segments; i++) {
     Dir *e = dir_index(vol, i);
     if (!dir_token(e) && dir_offset(e) >= (int64_t)start && dir_offset(e) < (int64_t)end) {
+      dir_segment_dirty(i / (vol->buckets * DIR_DEPTH), vol);
       CACHE_DEC_DIR_USED(vol->mutex);
       dir_set_offset(e, 0);     // delete
     }
@@ -408,6 +434,7 @@ freelist_clean(int s, Vol *vol)
   Warning("cache directory overflow on '%s' segment %d, purging...", vol->path, s);
   int n = 0;
   Dir *seg = dir_segment(s, vol);
+  dir_segment_dirty(s, vol);
   for (int bi = 0; bi < vol->buckets; bi++) {
     Dir *b = dir_bucket(bi, seg);
     for (int l = 0; l < DIR_DEPTH; l++) {
@@ -430,6 +457,7 @@ freelist_pop(int s, Vol *d)
     freelist_clean(s, d);
     return NULL;
   }
+  dir_segment_dirty(s, d);
   d->header->freelist[s] = dir_next(e);
   // if the freelist if bad, punt.
   if (dir_offset(e)) {
@@ -492,6 +520,7 @@ dir_free_entry(Dir *e, int s, Vol *d)
   Dir *seg = dir_segment(s, d);
   unsigned int fo = d->header->freelist[s];
   unsigned int eo = dir_to_offset(e, seg);
+  dir_segment_dirty(s, d);
   dir_set_next(e, fo);
   if (fo)
     dir_set_prev(dir_from_offset(fo, seg), eo);
@@ -505,18 +534,24 @@ dir_probe(CacheKey *key, Vol *d, Dir *result, Dir ** last_collision)
   int s = key->word(0) % d->segments;
   int b = key->word(1) % d->buckets;
   Dir *seg = dir_segment(s, d);
+  Dir *bucket = dir_bucket(b, seg);
   Dir *e = NULL, *p = NULL, *collision = *last_collision;
   Vol *vol = d;
+  uint32_t tag = DIR_MASK_TAG(key->word(2)), match;
   CHECK_DIR(d);
 #ifdef LOOP_CHECK_MODE
-  if (dir_bucket_loop_fix(dir_bucket(b, seg), s, d))
+  if (dir_bucket_loop_fix(bucket, s, d))
     return 0;
 #endif
 Lagain:
-  e = dir_bucket(b, seg);
+  e = bucket;
+  // compare the tags of the rows of the bucket at once, the chain
+  // rarely leaves the bucket
+  match = dir_bucket_tag_match(bucket, tag);
   if (dir_offset(e))
     do {
-      if (dir_compare_tag(e, key)) {
+      unsigned int row = (unsigned int) (((char *) e - (char *) bucket) / SIZEOF_DIR);
+      if (row < DIR_DEPTH ? (match >> row) & 1 : dir_compare_tag(e, key)) {
         ink_debug_assert(dir_offset(e));
         // Bug: 51680. Need to check collision before checking
         // dir_valid(). In case of a collision, if !dir_valid(), we
@@ -543,6 +578,8 @@ Lagain:
         } else {                // delete the invalid entry
           CACHE_DEC_DIR_USED(d->mutex);
           e = dir_delete_entry(e, p, s, d);
+          // deleting may have moved an entry into the bucket
+          match = dir_bucket_tag_match(bucket, tag);
           continue;
         }
       } else
@@ -584,10 +621,13 @@ dir_insert(CacheKey *key, Vol *d, Dir *to_part)
   CHECK_DIR(d);
 
 Lagain:
-  // get from this row first
+  // get from this row first, unlink_from_freelist() and freelist_pop()
+  // mark the segment dirty
   e = b;
-  if (dir_is_empty(e))
+  if (dir_is_empty(e)) {
+    dir_segment_dirty(s, d);
     goto Lfill;
+  }
   for (l = 1; l < DIR_DEPTH; l++) {
     e = dir_bucket_row(b, l);
     if (dir_is_empty(e)) {
@@ -654,6 +694,7 @@ Lagain:
     } while (e);
   if (must_overwrite)
     return 0;
+  dir_segment_dirty(s, d);
   res = 0;
   // get from this row first
   e = b;
@@ -677,6 +718,7 @@ Llink:
   dir_set_next(e, dir_next(b));
   dir_set_next(b, dir_to_offset(e, seg));
 Lfill:
+  dir_segment_dirty(s, d);
   dir_assign_data(e, dir);
   dir_set_tag(e, t);
   ink_assert(vol_offset(d, e) < d->skip + d->len);
@@ -919,7 +961,12 @@ sync_cache_dir_on_shutdown(void)
     // check if we have data in the agg buffer
     // dont worry about the cachevc s in the agg queue
     // directories have not been inserted for these writes
-    if (d->agg_buf_pos) {
+    // if a write is still in flight it can't be waited for or
+    // rewritten here, and the buffer being filled goes after it. Leave
+    // both out, recovery picks up whatever made it to disk.
+    if (d->agg_flush_len) {
+      Debug("cache_dir_sync", "Dir %s: agg write in flight, leaving agg buffers to recovery", d->hash_id);
+    } else if (d->agg_buf_pos) {
       Debug("cache_dir_sync", "Dir %s: flushing agg buffer first", d->hash_id);
 
       // set write limit
@@ -965,6 +1012,76 @@ sync_cache_dir_on_shutdown(void)
 }
 
 
+// Find the segments in the part [pos, pos + len) of the directory and
+// return whether that part must be written to the copy being synced,
+// i.e. whether it holds the header freelists or a segment which has
+// changed since it was last written to that copy.
+static bool
+dir_sync_window(Vol *d, off_t pos, off_t len, int *first, int *last)
+{
+  off_t base = vol_headerlen(d);
+  off_t segbytes = (off_t) d->buckets * DIR_DEPTH * SIZEOF_DIR;
+  bool changed = pos < base;
+  *first = pos < base ? 0 : (int) ((pos - base) / segbytes);
+  *last = pos + len <= base ? -1 : (int) ((pos + len - 1 - base) / segbytes);
+  if (*last >= d->segments)
+    *last = d->segments - 1;
+  for (int s = *first; s <= *last && !changed; s++)
+    changed = (d->dir_sync_state[s] & DIR_SYNC_WRITE) != 0;
+  return changed;
+}
+
+// Start a sync of the directory to the copy selected by the new
+// sync_serial. Rather than copying the whole directory, copy the
+// header and footer now and let dir_segment_dirty() copy the segments
+// to be written if they change before they are written.
+static void
+dir_sync_begin(Vol *d, char *buf)
+{
+  int headerlen = ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter));
+  off_t dirlen = vol_dirlen(d);
+  off_t base = vol_headerlen(d);
+  off_t end = base + (off_t) d->segments * d->buckets * DIR_DEPTH * SIZEOF_DIR;
+  int B = d->header->sync_serial & 1, first, last;
+
+  memcpy(buf, d->raw_dir, base);
+  memcpy(buf + end, d->raw_dir + end, dirlen - end);
+  for (int s = 0; s < d->segments; s++) {
+    uint8_t st = d->dir_sync_state[s] & (DIR_SYNC_DIRTY(0) | DIR_SYNC_DIRTY(1));
+    if (st & DIR_SYNC_DIRTY(B))
+      st = (st & ~DIR_SYNC_DIRTY(B)) | DIR_SYNC_WRITE;
+    d->dir_sync_state[s] = st;
+  }
+  // unchanged segments sharing a write with a changed one must be
+  // written as they are now as well
+  for (off_t pos = headerlen; pos < dirlen - headerlen; pos += SYNC_MAX_WRITE) {
+    off_t l = SYNC_MAX_WRITE;
+    if (pos + l > dirlen - headerlen)
+      l = dirlen - headerlen - pos;
+    if (dir_sync_window(d, pos, l, &first, &last))
+      for (int s = first; s <= last; s++)
+        d->dir_sync_state[s] |= DIR_SYNC_SNAP;
+  }
+  d->dir_sync_buf = buf;
+  d->dir_sync_in_progress = 1;
+}
+
+// Finish or abandon the sync. If it failed the copy may have been
+// partially overwritten, so write all of it next time, and the
+// directory is still dirty.
+static void
+dir_sync_end(Vol *d, bool ok)
+{
+  int B = d->header->sync_serial & 1;
+  for (int s = 0; s < d->segments; s++) {
+    uint8_t st = d->dir_sync_state[s] & (DIR_SYNC_DIRTY(0) | DIR_SYNC_DIRTY(1));
+    d->dir_sync_state[s] = ok ? st : st | DIR_SYNC_DIRTY(B);
+  }
+  if (!ok)
+    d->header->dirty = 1;
+  d->dir_sync_buf = NULL;
+  d->dir_sync_in_progress = 0;
+}
 
 int
 CacheSync::mainEvent(int event, Event *e)
@@ -996,8 +1113,9 @@ Lrestart:
     // AIO Thread
     if (io.aio_result != (int64_t)io.aiocb.aio_nbytes) {
       Warning("vol write error during directory sync '%s'", gvol[vol]->hash_id);
-      event = EVENT_NONE;
-      goto Ldone;
+      // abandon the sync under the vol lock
+      trigger = eventProcessor.schedule_imm(this, ET_CALL, EVENT_ERROR);
+      return EVENT_CONT;
     }
     trigger = eventProcessor.schedule_in(this, SYNC_DELAY);
     return EVENT_CONT;
@@ -1005,7 +1123,8 @@ Lrestart:
   {
     CACHE_TRY_LOCK(lock, gvol[vol]->mutex, mutex->thread_holding);
     if (!lock) {
-      trigger = eventProcessor.schedule_in(this, HRTIME_MSECONDS(cache_config_mutex_retry_delay));
+      trigger = eventProcessor.schedule_in(this, HRTIME_MSECONDS(cache_config_mutex_retry_delay), ET_CALL,
+                                           event == EVENT_ERROR ? EVENT_ERROR : EVENT_INTERVAL);
       return EVENT_CONT;
     }
     Vol *d = gvol[vol];
@@ -1015,8 +1134,11 @@ Lrestart:
     d->hit_evacuate_window = (d->data_blocks * cache_config_hit_evacuate_percent) / 100;
 #endif
 
-    if (DISK_BAD(d->disk))
+    if (event == EVENT_ERROR || DISK_BAD(d->disk)) {
+      if (d->dir_sync_in_progress)
+        dir_sync_end(d, false);
       goto Ldone;
+    }
 
     int headerlen = ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter));
     size_t dirlen = vol_dirlen(d);
@@ -1051,11 +1173,22 @@ Lrestart:
       d->header->sync_serial++;
       d->footer->sync_serial = d->header->sync_serial;
       CHECK_DIR(d);
-      memcpy(buf, d->raw_dir, dirlen);
-      d->dir_sync_in_progress = 1;
+      dir_sync_begin(d, buf);
     }
     size_t B = d->header->sync_serial & 1;
     off_t start = d->skip + (B ? dirlen : 0);
+    int l = 0, first = 0, last = -1;
+
+    // skip the parts of the body which have not changed since
+    // they were last written to this copy
+    while (writepos && writepos < (off_t)dirlen - headerlen) {
+      l = SYNC_MAX_WRITE;
+      if (writepos + l > (off_t)dirlen - headerlen)
+        l = dirlen - headerlen - writepos;
+      if (dir_sync_window(d, writepos, l, &first, &last))
+        break;
+      writepos += l;
+    }
 
     if (!writepos) {
       // write header
@@ -1063,9 +1196,8 @@ Lrestart:
       writepos += headerlen;
     } else if (writepos < (off_t)dirlen - headerlen) {
       // write part of body
-      int l = SYNC_MAX_WRITE;
-      if (writepos + l > (off_t)dirlen - headerlen)
-        l = dirlen - headerlen - writepos;
+      for (int s = first; s <= last; s++)
+        dir_segment_snap(s, d);
       aio_write(d->fd, buf + writepos, l, start + writepos);
       writepos += l;
     } else if (writepos < (off_t)dirlen) {
@@ -1074,7 +1206,7 @@ Lrestart:
       aio_write(d->fd, buf + writepos, headerlen, start + writepos);
       writepos += headerlen;
     } else {
-      d->dir_sync_in_progress = 0;
+      dir_sync_end(d, true);
       goto Ldone;
     }
     return EVENT_CONT;
@@ -1269,6 +1401,7 @@ dir_corrupt_bucket(Dir *b, int s, Vol *d)
     ink_release_assert(e);
     e = next_dir(e, seg);
   }
+  dir_segment_dirty(s, d);
   dir_set_next(e, dir_to_offset(e, seg));
 }
 
@@ -1321,6 +1454,7 @@ EXCLUSIVE_REGRESSION_TEST(Cache_dir) (RegressionTest *t, int atype, int *status)
 
   // test delete
   rprintf(t, "delete test\n");
+  dir_segment_dirty(s, d);
   for (i = 0; i < d->buckets; i++)
     for (j = 0; j < DIR_DEPTH; j++)
       dir_set_offset(dir_bucket_row(dir_bucket(i, seg), j), 0); // delete
@@ -1446,3 +1580,149 @@ EXCLUSIVE_REGRESSION_TEST(Cache_dir) (RegressionTest *t, int atype, int *status)
   vol_dir_clear(d);
   *status = ret;
 }
+
+// Probe cost on a standalone directory filled to 75%, with 100M entries
+// for extended runs (about 1GB of directory).
+// a directory which is not attached to a disk
+static Vol *
+regress_new_vol(int64_t entries)
+{
+  Vol *d = NEW(new Vol());
+
+  d->buckets = entries / DIR_DEPTH;
+  d->segments = (d->buckets + (((1<<16)-1)/DIR_DEPTH)) / ((1<<16)/DIR_DEPTH);
+  d->buckets = (d->buckets + d->segments - 1) / d->segments;
+  d->raw_dir = (char *)ats_memalign(sysconf(_SC_PAGESIZE), vol_dirlen(d));
+  memset(d->raw_dir, 0, vol_dirlen(d));
+  d->header = (VolHeaderFooter *) d->raw_dir;
+  d->footer = (VolHeaderFooter *) (d->raw_dir + vol_dirlen(d) - ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter)));
+  d->dir = (Dir *) (d->raw_dir + vol_headerlen(d));
+  d->dir_sync_state = (uint8_t *)ats_malloc(d->segments);
+  memset(d->dir_sync_state, 0, d->segments);
+  vol_init_dir(d);
+  d->len = d->header->agg_pos = d->header->write_pos = 1024;
+  return d;
+}
+
+EXCLUSIVE_REGRESSION_TEST(Cache_dir_probe) (RegressionTest *t, int atype, int *status) {
+  int64_t entries = atype >= REGRESSION_TEST_EXTENDED ? 100000000 : 1000000;
+  int64_t n = entries / 4 * 3, i, inserted = 0, hits = 0, misses = 0;
+  ink_hrtime ttime, hit_ns, miss_ns;
+  Vol *d = regress_new_vol(entries);
+  {
+    MUTEX_TRY_LOCK(lock, d->mutex, this_ethread());
+    ink_release_assert(lock);
+
+    Dir dir;
+    dir_clear(&dir);
+    dir_set_head(&dir, true);
+    dir_set_offset(&dir, 1);
+    CacheKey key;
+
+    regress_rand_init(13);
+    for (i = 0; i < n; i++) {
+      regress_rand_CacheKey(&key);
+      inserted += dir_insert(&key, d, &dir);
+    }
+    regress_rand_init(13);
+    ttime = ink_get_hrtime_internal();
+    for (i = 0; i < n; i++) {
+      Dir *last_collision = 0;
+      regress_rand_CacheKey(&key);
+      hits += dir_probe(&key, d, &dir, &last_collision);
+    }
+    hit_ns = ink_get_hrtime_internal() - ttime;
+    regress_rand_init(17);
+    ttime = ink_get_hrtime_internal();
+    for (i = 0; i < n; i++) {
+      Dir *last_collision = 0;
+      regress_rand_CacheKey(&key);
+      misses += !dir_probe(&key, d, &dir, &last_collision);
+    }
+    miss_ns = ink_get_hrtime_internal() - ttime;
+  }
+  rprintf(t, "%" PRId64 " entries, %" PRId64 " inserted\n", entries, inserted);
+  rprintf(t, "hit probe: %" PRId64 " ns (%" PRId64 " found)\n", (int64_t) (hit_ns / n), hits);
+  rprintf(t, "miss probe: %" PRId64 " ns (%" PRId64 " missed)\n", (int64_t) (miss_ns / n), misses);
+  *status = hits >= inserted ? REGRESSION_TEST_PASSED : REGRESSION_TEST_FAILED;
+  ats_memalign_free(d->raw_dir);
+  delete d;
+}
+
+// check that an incremental sync writes the directory as it was when
+// the sync started, and only the parts which changed
+EXCLUSIVE_REGRESSION_TEST(Cache_dir_sync) (RegressionTest *t, int atype, int *status) {
+  NOWARN_UNUSED(atype);
+  Vol *d = regress_new_vol(4000000);
+  int headerlen = ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter));
+  off_t dirlen = vol_dirlen(d);
+  char *buf = (char *)ats_memalign(sysconf(_SC_PAGESIZE), dirlen);
+  char *snap = (char *)ats_memalign(sysconf(_SC_PAGESIZE), dirlen);
+  int ret = REGRESSION_TEST_PASSED, written = 0, windows = 0, first, last;
+  {
+    MUTEX_TRY_LOCK(lock, d->mutex, this_ethread());
+    ink_release_assert(lock);
+
+    Dir dir;
+    dir_clear(&dir);
+    dir_set_head(&dir, true);
+    dir_set_offset(&dir, 1);
+    CacheKey key;
+    regress_rand_init(13);
+    for (int i = 0; i < 100000; i++) {
+      regress_rand_CacheKey(&key);
+      dir_insert(&key, d, &dir);
+    }
+    // both copies written, then one change
+    memset(d->dir_sync_state, 0, d->segments);
+    regress_rand_CacheKey(&key);
+    dir_insert(&key, d, &dir);
+
+    d->header->sync_serial++;
+    d->footer->sync_serial = d->header->sync_serial;
+    memset(buf, 0xFF, dirlen);
+    memcpy(snap, d->raw_dir, dirlen);
+    dir_sync_begin(d, buf);
+    // changes while the sync is in progress
+    for (int i = 0; i < 1000; i++) {
+      regress_rand_CacheKey(&key);
+      dir_insert(&key, d, &dir);
+    }
+    if (memcmp(buf, snap, headerlen) || memcmp(buf + dirlen - headerlen, snap + dirlen - headerlen, headerlen))
+      ret = REGRESSION_TEST_FAILED;
+    for (off_t pos = headerlen; pos < dirlen - headerlen; pos += SYNC_MAX_WRITE, windows++) {
+      off_t l = SYNC_MAX_WRITE;
+      if (pos + l > dirlen - headerlen)
+        l = dirlen - headerlen - pos;
+      if (!dir_sync_window(d, pos, l, &first, &last))
+        continue;
+      written++;
+      for (int s = first; s <= last; s++)
+        dir_segment_snap(s, d);
+      if (memcmp(buf + pos, snap + pos, l))
+        ret = REGRESSION_TEST_FAILED;
+    }
+    dir_sync_end(d, true);
+    if (d->dir_sync_buf || d->dir_sync_in_progress || written < 1 || written >= windows)
+      ret = REGRESSION_TEST_FAILED;
+
+    // an abandoned sync leaves the directory dirty and its copy to be
+    // written in full
+    int B = d->header->sync_serial & 1;
+    d->header->dirty = 0;
+    dir_sync_begin(d, buf);
+    dir_sync_end(d, false);
+    if (d->dir_sync_buf || d->dir_sync_in_progress || !d->header->dirty)
+      ret = REGRESSION_TEST_FAILED;
+    for (int s = 0; s < d->segments; s++)
+      if (d->dir_sync_state[s] != (d->dir_sync_state[s] & (DIR_SYNC_DIRTY(0) | DIR_SYNC_DIRTY(1))) ||
+          !(d->dir_sync_state[s] & DIR_SYNC_DIRTY(B)))
+        ret = REGRESSION_TEST_FAILED;
+  }
+  rprintf(t, "%d segments, wrote %d of %d parts\n", d->segments, written, windows);
+  *status = ret;
+  ats_memalign_free(buf);
+  ats_memalign_free(snap);
+  ats_memalign_free(d->raw_dir);
+  delete d;
+}
@@ -268,7 +268,7 @@ ShowCacheInternal::showVolVolumes(int event, Event * e)
   ink_ctime_r(&p->header->create_time, ctime);
   ctime[strlen(ctime) - 1] = 0;
   int agg_todo = 0;
-  int agg_done = p->agg_buf_pos;
+  int agg_done = p->agg_flush_len + p->agg_buf_pos;
   CacheVC *c = 0;
   for (c = p->agg.head; c; c = (CacheVC *) c->link.next)
     agg_todo++;
@@ -704,6 +704,8 @@ Lread: {
     }
     if (dir_probe(&key, vol, &dir, &last_collision)) {
       SET_HANDLER(&CacheVC::openReadReadDone);
+      if (cache_config_read_ahead_fragments > 0 && !f.single_fragment)
+        read_ahead();
       int ret = do_read_call(&key);
       if (ret == EVENT_RETURN)
         goto Lcallreturn;
@@ -741,6 +743,113 @@ Lcallreturn:
   return handleEvent(AIO_EVENT_DONE, 0);
 }
 
+/*
+  Issue reads for up to cache_config_read_ahead_fragments fragments
+  following 'key' (the fragment about to be read), bounded by the
+  volume wide cache_config_read_ahead_max_pending and by what the
+  reader still wants. The reads complete into CacheReadAhead buffers,
+  which handleRead picks up instead of going to disk. Called with the
+  volume lock held.
+*/
+void
+CacheVC::read_ahead()
+{
+  CacheKey k(key);
+  CacheReadAhead *ra = read_ahead_list, *last = NULL;
+  int n = 0;
+  int64_t ahead = dir_approx_size(&dir);
+
+  if (ra && ra->key == key)
+    ra = ra->next; // about to be consumed by this read
+  for (; ra; ra = ra->next) {
+    next_CacheKey(&k, &k);
+    if (!(ra->key == k)) {
+      // the reader moved (do_io_pread), start over from here
+      cancel_read_ahead();
+      k = key;
+      n = 0;
+      ahead = dir_approx_size(&dir);
+      last = NULL;
+      break;
+    }
+    ahead += ra->io.aiocb.aio_nbytes;
+    last = ra;
+    n++;
+  }
+  while (n < cache_config_read_ahead_fragments && ahead < vio.ntodo() &&
+         vol->read_ahead_pending < cache_config_read_ahead_max_pending) {
+    Dir d, *collision = NULL;
+    next_CacheKey(&k, &k);
+    if (!dir_probe(&k, vol, &d, &collision) || dir_agg_buf_valid(vol, &d))
+      break;
+    ra = cacheReadAheadAllocator.alloc();
+    ra->key = k;
+    ra->dir = d;
+    ra->vol = vol;
+    ra->vc = this;
+    ra->mutex = mutex;
+    ra->io.aiocb.aio_fildes = vol->fd;
+    ra->io.aiocb.aio_offset = vol_offset(vol, &d);
+    ra->io.aiocb.aio_nbytes = dir_approx_size(&d);
+    if ((off_t)(ra->io.aiocb.aio_offset + ra->io.aiocb.aio_nbytes) > (off_t)(vol->skip + vol->len))
+      ra->io.aiocb.aio_nbytes = vol->skip + vol->len - ra->io.aiocb.aio_offset;
+    ra->io.aiocb.aio_reqprio = io.aiocb.aio_reqprio;
+    ra->buf = new_IOBufferData(iobuffer_size_to_index(ra->io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
+    ra->io.aiocb.aio_buf = ra->buf->data();
+    ra->io.action = ra;
+    ra->io.thread = mutex->thread_holding->tt == DEDICATED ? AIO_CALLBACK_THREAD_ANY : mutex->thread_holding;
+    if (last)
+      last->next = ra;
+    else
+      read_ahead_list = ra;
+    last = ra;
+    ahead += ra->io.aiocb.aio_nbytes;
+    n++;
+    ink_atomic_increment(&vol->read_ahead_pending, 1);
+    CACHE_INCREMENT_DYN_STAT(cache_read_ahead_issued_stat);
+    ink_assert(ink_aio_read(&ra->io) >= 0);
+  }
+}
+
+void
+CacheVC::cancel_read_ahead()
+{
+  CacheReadAhead *ra;
+  while ((ra = read_ahead_list)) {
+    read_ahead_list = ra->next;
+    ra->next = NULL;
+    CACHE_INCREMENT_DYN_STAT(cache_read_ahead_wasted_stat);
+    if (ra->done)
+      free_CacheReadAhead(ra);
+    else
+      ra->vc = NULL; // freed by readDone
+  }
+}
+
+int
+CacheReadAhead::readDone(int event, void *data)
+{
+  NOWARN_UNUSED(event);
+  NOWARN_UNUSED(data);
+  ink_atomic_increment(&vol->read_ahead_pending, -1);
+  done = true;
+  CacheVC *c = vc;
+  if (!c) {
+    free_CacheReadAhead(this);
+    return EVENT_DONE;
+  }
+  if (c->read_ahead_wait != this)
+    return EVENT_CONT;
+  // the reader is blocked in handleRead on this fragment
+  c->read_ahead_wait = NULL;
+  c->io.aiocb.aio_offset = io.aiocb.aio_offset;
+  c->io.aiocb.aio_nbytes = io.aiocb.aio_nbytes;
+  c->io.aio_result = io.aio_result;
+  c->buf = buf;
+  free_CacheReadAhead(this);
+  return c->handleEvent(AIO_EVENT_DONE, 0);
+}
+
 /*
   This code follows CacheVC::openReadStartHead closely,
   if you change this you might have to change that.
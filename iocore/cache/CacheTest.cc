@@ -414,5 +414,28 @@ EXCLUSIVE_REGRESSION_TEST(cache)(RegressionTest *t, int atype, int *pstatus) {
   return;
 }
 
+REGRESSION_TEST(cache_admission)(RegressionTest *t, int atype, int *pstatus) {
+  NOWARN_UNUSED(atype);
+  CacheAdmission a;
+  CacheKey hot, cold;
+  int ret = REGRESSION_TEST_PASSED;
+  a.init(100000, 1000);
+  rand_CacheKey(&hot, this_ethread()->mutex);
+  for (int i = 1; i <= 3; i++)
+    if (a.access(&hot) != i)
+      ret = REGRESSION_TEST_FAILED;
+  // a stream of one-time keys ages the counts without making them hot
+  int hits = 0;
+  for (int i = 0; i < 5000; i++) {
+    rand_CacheKey(&cold, this_ethread()->mutex);
+    if (a.access(&cold) > 1)
+      hits++;
+  }
+  rprintf(t, "one-time keys counted more than once: %d of 5000\n", hits);
+  if (hits > 50 || a.access(&hot) > 2)
+    ret = REGRESSION_TEST_FAILED;
+  *pstatus = ret;
+}
+
 void force_link_CacheTest() {
 }
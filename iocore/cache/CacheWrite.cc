@@ -189,7 +189,7 @@ CacheVC::handleWrite(int event, Event *e)
   vol->agg_todo_size += agg_len;
   bool agg_error =
     (agg_len > AGG_SIZE || header_len + sizeofDoc > MAX_FRAG_SIZE ||
-     (!f.readers && (vol->agg_todo_size > cache_config_agg_write_backlog + AGG_SIZE) && write_len));
+     (!f.readers && (vol->agg_todo_size > cache_config_agg_write_backlog + vol->agg_size) && write_len));
 #ifdef CACHE_AGG_FAIL_RATE
   agg_error = agg_error || ((uint32_t) mutex->thread_holding->generator.random() <
                             (uint32_t) (UINT_MAX * CACHE_AGG_FAIL_RATE));
@@ -207,14 +207,15 @@ CacheVC::handleWrite(int event, Event *e)
       return EVENT_RETURN;
     return handleEvent(AIO_EVENT_DONE, 0);
   }
+  // each document goes whole into one agg buffer, which is never smaller
+  // than AGG_SIZE
   ink_assert(agg_len <= AGG_SIZE);
   if (f.evac_vector)
     vol->agg.push(this);
   else
     vol->agg.enqueue(this);
-  if (!vol->is_io_in_progress())
-    return vol->aggWrite(event, this);
-  return EVENT_CONT;
+  // aggWrite() only fills the agg buffer while the other one is in flight
+  return vol->aggWrite(event, this);
 }
 
 static char *
@@ -272,9 +273,9 @@ Vol::scan_for_pinned_documents()
 {
   if (cache_config_permit_pinning) {
     // we can't evacuate anything between header->write_pos and
-    // header->write_pos + AGG_SIZE.
-    int ps = offset_to_vol_offset(this, header->write_pos + AGG_SIZE);
-    int pe = offset_to_vol_offset(this, header->write_pos + 2 * EVACUATION_SIZE + (len / PIN_SCAN_EVERY));
+    // header->write_pos + agg_size.
+    int ps = offset_to_vol_offset(this, header->write_pos + agg_size);
+    int pe = offset_to_vol_offset(this, header->write_pos + 2 * vol_evacuation_size(this) + (len / PIN_SCAN_EVERY));
     int vol_end_offset = offset_to_vol_offset(this, len + skip);
     int before_end_of_vol = pe < vol_end_offset;
     DDebug("cache_evac", "scan %d %d", ps, pe);
@@ -325,10 +326,9 @@ Vol::aggWriteDone(int event, Event *e)
     DDebug("cache_agg", "Dir %s, Write: %" PRIu64 ", last Write: %" PRIu64 "\n",
           hash_id, header->write_pos, header->last_write_pos);
     ink_assert(header->write_pos == header->agg_pos);
-    if (header->write_pos + EVACUATION_SIZE > scan_pos)
+    agg_flush_len = 0;
+    if (header->write_pos + vol_evacuation_size(this) > scan_pos)
       periodic_scan();
-    agg_buf_pos = 0;
-    header->write_serial++;
   } else {
     // delete all the directory entries that we inserted
     // for fragments is this aggregation buffer
@@ -337,18 +337,24 @@ Vol::aggWriteDone(int event, Event *e)
           hash_id, io.aiocb.aio_offset, io.aiocb.aio_offset + io.aiocb.aio_nbytes,
           io.aiocb.aio_offset / CACHE_BLOCK_SIZE,
           (io.aiocb.aio_offset + io.aiocb.aio_nbytes) / CACHE_BLOCK_SIZE);
+    // the buffer filled while this one was in flight was laid out
+    // after it, so drop its entries as well
     Dir del_dir;
     dir_clear(&del_dir);
-    for (int done = 0; done < agg_buf_pos;) {
-      Doc *doc = (Doc *) (agg_buffer + done);
+    for (int done = 0; done < agg_flush_len + agg_buf_pos;) {
+      Doc *doc = (Doc *) (done < agg_flush_len ? agg_flush_buffer + done : agg_buffer + (done - agg_flush_len));
       dir_set_offset(&del_dir, header->write_pos + done);
       dir_delete(&doc->key, this, &del_dir);
       done += round_to_approx_size(doc->len);
     }
+    agg_flush_len = 0;
     agg_buf_pos = 0;
   }
   set_io_not_in_progress();
-  // callback ready sync CacheVCs
+  // callback ready sync CacheVCs. write_serial was bumped when this
+  // buffer was handed off, so it holds the documents of serial
+  // write_serial - 1, and those of write_serial - 2 are followed on disk
+  // by a completed write.
   CacheVC *c = 0;
   while ((c = sync.dequeue())) {
     if (UINT_WRAP_LTE(c->write_serial + 2, header->write_serial))
@@ -362,7 +368,7 @@ Vol::aggWriteDone(int event, Event *e)
     dir_sync_waiting = 0;
     cacheDirSync->handleEvent(EVENT_IMMEDIATE, 0);
   }
-  if (agg.head || sync.head)
+  if (!is_io_in_progress() && (agg_buf_pos || agg.head || sync.head))
     return aggWrite(event, e);
   return EVENT_CONT;
 }
@@ -597,6 +603,7 @@ Vol::evacuateWrite(CacheVC *evacuator, int event, Event *e)
   CacheVC *after = NULL;
   for (; cur && cur->f.evacuator; cur = (CacheVC *) cur->link.next)
     after = cur;
+  // it was admitted by handleWrite(), whatever agg_size was in effect
   ink_assert(evacuator->agg_len <= AGG_SIZE);
   agg.insert(evacuator, after);
   return aggWrite(event, e);
@@ -738,7 +745,7 @@ static int
 agg_copy(char *p, CacheVC *vc)
 {
   Vol *vol = vc->vol;
-  off_t o = vol->header->write_pos + vol->agg_buf_pos;
+  off_t o = vol->header->write_pos + vol->agg_flush_len + vol->agg_buf_pos;
 
   if (!vc->f.evacuator) {
     Doc *doc = (Doc *) p;
@@ -965,10 +972,10 @@ Vol::aggWrite(int event, void *e)
 {
   NOWARN_UNUSED(e);
   NOWARN_UNUSED(event);
-  ink_assert(!is_io_in_progress());
 
   Que(CacheVC, link) tocall;
   CacheVC *c;
+  off_t end;
 
   cancel_trigger();
 
@@ -976,12 +983,12 @@ Lagain:
   // calculate length of aggregated write
   for (c = (CacheVC *) agg.head; c;) {
     int writelen = c->agg_len;
-    ink_assert(writelen < AGG_SIZE);
-    if (agg_buf_pos + writelen > AGG_SIZE ||
-        header->write_pos + agg_buf_pos + writelen > (skip + len))
+    ink_assert(writelen <= agg_size);
+    if (agg_buf_pos + writelen > agg_size ||
+        header->write_pos + agg_flush_len + agg_buf_pos + writelen > (skip + len))
       break;
     DDebug("agg_read", "copying: %d, %" PRIu64 ", key: %d",
-          agg_buf_pos, header->write_pos + agg_buf_pos, c->first_key.word(0));
+          agg_buf_pos, header->write_pos + agg_flush_len + agg_buf_pos, c->first_key.word(0));
     int wrotelen = agg_copy(agg_buffer + agg_buf_pos, c);
     ink_assert(writelen == wrotelen);
     agg_todo_size -= writelen;
@@ -1000,6 +1007,11 @@ Lagain:
     c = n;
   }
 
+  // keep filling while the other buffer (or an evacuation read) is in
+  // flight, aggWriteDone() will write this one out
+  if (is_io_in_progress())
+    goto Lwait;
+
   // if we got nothing...
   if (!agg_buf_pos) {
     if (!agg.head && !sync.head) // nothing to get
@@ -1026,7 +1038,7 @@ Lagain:
   }
 
   // evacuate space
-  off_t end = header->write_pos + agg_buf_pos + EVACUATION_SIZE;
+  end = header->write_pos + agg_buf_pos + vol_evacuation_size(this);
   if (evac_range(header->write_pos, end, !header->phase) < 0)
     goto Lwait;
   if (end > skip + len)
@@ -1035,7 +1047,7 @@ Lagain:
 
   // if agg.head, then we are near the end of the disk, so
   // write down the aggregation in whatever size it is.
-  if (agg_buf_pos < AGG_HIGH_WATER && !agg.head && !sync.head && !dir_sync_waiting)
+  if (agg_buf_pos < AGG_HIGH_WATER(this) && !agg.head && !sync.head && !dir_sync_waiting)
     goto Lwait;
 
   // write sync marker
@@ -1054,10 +1066,21 @@ Lagain:
   // set write limit
   header->agg_pos = header->write_pos + agg_buf_pos;
 
+  // swap buffers, new writes fill the other one while this is in flight
+  // and must not share its write serial
+  {
+    char *b = agg_flush_buffer;
+    agg_flush_buffer = agg_buffer;
+    agg_buffer = b;
+    agg_flush_len = agg_buf_pos;
+    agg_buf_pos = 0;
+  }
+  header->write_serial++;
+
   io.aiocb.aio_fildes = fd;
   io.aiocb.aio_offset = header->write_pos;
-  io.aiocb.aio_buf = agg_buffer;
-  io.aiocb.aio_nbytes = agg_buf_pos;
+  io.aiocb.aio_buf = agg_flush_buffer;
+  io.aiocb.aio_nbytes = agg_flush_len;
   io.action = this;
   /*
     Callback on AIO thread so that we can issue a new write ASAP
@@ -1477,6 +1500,21 @@ Lcallreturn:
 }
 
 #ifdef HTTP_CACHE
+// Decide whether to write a new document, which must have missed
+// cache_config_admission_threshold times recently. Requires the vol lock.
+static inline bool
+admit_write(Vol *vol, CacheKey *key, ProxyMutex *mutex)
+{
+  if (!vol->admission.count)
+    return true;
+  if (vol->admission.access(key) < cache_config_admission_threshold) {
+    CACHE_INCREMENT_DYN_STAT(cache_admission_rejected_stat);
+    return false;
+  }
+  CACHE_INCREMENT_DYN_STAT(cache_admission_admitted_stat);
+  return true;
+}
+
 // openWriteStartDone handles vector read (addition of alternates)
 // and lock misses
 int
@@ -1571,6 +1609,10 @@ Lcollision:
       // fail update because vector has been GC'd
       goto Lfailure;
     }
+    if (!admit_write(vol, &first_key, mutex)) {
+      err = ECACHE_NOT_ADMITTED;
+      goto Lfailure;
+    }
   }
 Lsuccess:
   od->reading_vec = 0;
@@ -1786,6 +1828,10 @@ Cache::open_write(Continuation *cont, CacheKey *key, CacheHTTPInfo *info, time_t
           goto Lfailure;
         }
         // document doesn't exist, begin write
+        if (!admit_write(c->vol, key, mutex)) {
+          err = ECACHE_NOT_ADMITTED;
+          goto Lfailure;
+        }
         goto Lmiss;
       } else {
         c->od->reading_vec = 1;
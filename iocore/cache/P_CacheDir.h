@@ -26,6 +26,9 @@
 #define _P_CACHE_DIR_H__
 
 #include "P_CacheHttp.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 struct Vol;
 struct CacheVC;
@@ -54,6 +57,12 @@ struct CacheVC;
 
 #define SYNC_MAX_WRITE                  (2 * 1024 * 1024)
 #define SYNC_DELAY                      HRTIME_MSECONDS(500)
+
+// Vol::dir_sync_state flags, one byte per directory segment
+#define DIR_SYNC_DIRTY(_b)              (1 << (_b))     // changed since last written to copy _b
+#define DIR_SYNC_WRITE                  4       // dirty when the current sync started
+#define DIR_SYNC_SNAP                   8       // shares a sync write with a DIR_SYNC_WRITE segment
+#define DIR_SYNC_COPIED                 16      // already copied into the sync buffer
 #define DO_NOT_REMOVE_THIS              0
 
 // Debugging Options
@@ -292,6 +301,7 @@ int dir_lookaside_fixup(CacheKey *key, Vol *d);
 void dir_lookaside_cleanup(Vol *d);
 void dir_lookaside_remove(CacheKey *key, Vol *d);
 void dir_free_entry(Dir *e, int s, Vol *d);
+void dir_segment_dirty(int s, Vol *d);
 void dir_sync_init();
 int check_dir(Vol *d);
 void dir_clean_vol(Vol *d);
@@ -356,4 +366,27 @@ dir_bucket_row(Dir *b, int i)
   return dir_in_seg(b, i);
 }
 
+// Bitmask of the rows of bucket _b whose tag is _t. Rows are not
+// necessarily in use or on the bucket chain, the caller must check.
+TS_INLINE uint32_t
+dir_bucket_tag_match(Dir *b, uint32_t t)
+{
+#if defined(__SSE2__) && DIR_DEPTH == 4
+  // the tags are in w[2] of each row, i.e. u16 2, 7, 12 and 17 of the bucket
+  __m128i m = _mm_set1_epi16((1 << DIR_TAG_WIDTH) - 1);
+  __m128i k = _mm_set1_epi16((short) t);
+  __m128i lo = _mm_loadu_si128((__m128i *) &b->w[2]);
+  __m128i hi = _mm_loadu_si128((__m128i *) &dir_bucket_row(b, 2)->w[2]);
+  uint32_t l = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(lo, m), k));
+  uint32_t h = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(hi, m), k));
+  return (l & 1) | ((l >> 9) & 2) | ((h & 1) << 2) | ((h >> 7) & 8);
+#else
+  uint32_t r = 0;
+  for (int i = 0; i < DIR_DEPTH; i++)
+    if (dir_tag(dir_bucket_row(b, i)) == t)
+      r |= 1 << i;
+  return r;
+#endif
+}
+
 #endif /* _P_CACHE_DIR_H__ */
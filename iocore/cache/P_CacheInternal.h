@@ -33,6 +33,7 @@
 #endif
 
 struct EvacuationBlock;
+struct CacheReadAhead;
 
 // Compilation Options
 
@@ -158,6 +159,15 @@ enum
   cache_hdr_vector_marshal_stat,
   cache_hdr_marshal_stat,
   cache_hdr_marshal_bytes_stat,
+  cache_read_ahead_issued_stat,
+  cache_read_ahead_hits_stat,
+  cache_read_ahead_wasted_stat,
+  cache_ram_cache_compress_bytes_in_stat,
+  cache_ram_cache_compress_bytes_saved_stat,
+  cache_ram_cache_compress_ratio_stat,
+  cache_ram_cache_decompress_time_stat,
+  cache_admission_admitted_stat,
+  cache_admission_rejected_stat,
   cache_stat_count
 };
 
@@ -214,6 +224,7 @@ extern int cache_config_vary_on_user_agent;
 extern int cache_config_max_doc_size;
 extern int cache_config_min_average_object_size;
 extern int cache_config_agg_write_backlog;
+extern int cache_config_agg_write_size;
 extern int cache_config_enable_checksum;
 extern int cache_config_alt_rewrite_max_size;
 extern int cache_config_read_while_writer;
@@ -222,6 +233,10 @@ extern int cache_clustering_enabled;
 extern int cache_config_agg_write_backlog;
 extern int cache_config_ram_cache_compress;
 extern int cache_config_ram_cache_compress_percent;
+extern int cache_config_ram_cache_shards;
+extern int cache_config_ram_cache_compress_cpu_percent;
+extern int cache_config_admission_threshold;
+extern int cache_config_admission_window;
 #ifdef HIT_EVACUATE
 extern int cache_config_hit_evacuate_percent;
 extern int cache_config_hit_evacuate_size_limit;
@@ -229,6 +244,8 @@ extern int cache_config_hit_evacuate_size_limit;
 extern int cache_config_force_sector_size;
 extern int cache_config_target_fragment_size;
 extern int cache_config_mutex_retry_delay;
+extern int cache_config_read_ahead_fragments;
+extern int cache_config_read_ahead_max_pending;
 
 // CacheVC
 struct CacheVC: public CacheVConnection
@@ -286,7 +303,10 @@ struct CacheVC: public CacheVConnection
 
   int handleReadDone(int event, Event *e);
   int handleRead(int event, Event *e);
+  int handleReadRamCache(int event, Event *e);
   int do_read_call(CacheKey *akey);
+  void read_ahead();
+  void cancel_read_ahead();
   int handleWrite(int event, Event *e);
   int handleWriteLock(int event, Event *e);
   int do_write_call();
@@ -447,6 +467,8 @@ struct CacheVC: public CacheVConnection
   int fragment;
   int scan_msec_delay;
   CacheVC *write_vc;
+  CacheReadAhead *read_ahead_list;  // fragments read ahead of 'key', in key order
+  CacheReadAhead *read_ahead_wait;  // read ahead we are waiting on instead of io
   char *hostname;
   int host_len;
   int header_to_write_len;
@@ -500,6 +522,29 @@ struct CacheVC: public CacheVConnection
     ink_assert(handler != (ContinuationHandler)(&CacheVC::dead)); \
   } while (0)
 
+/* A fragment read issued ahead of the reader (CacheVC::read_ahead), so
+   the disk works on the next fragments of a large object while the
+   current one is being sent. */
+struct CacheReadAhead: public Continuation
+{
+  CacheKey key;
+  Dir dir;
+  Ptr<IOBufferData> buf;
+  AIOCallbackInternal io;
+  CacheVC *vc;                  // NULL once the reader is gone
+  Vol *vol;
+  CacheReadAhead *next;
+  bool done;
+
+  int readDone(int event, void *data);
+
+  CacheReadAhead()
+    : Continuation(NULL), vc(NULL), vol(NULL), next(NULL), done(false)
+  {
+    SET_HANDLER(&CacheReadAhead::readDone);
+  }
+};
+
 struct CacheRemoveCont: public Continuation
 {
   int event_handler(int event, void *data);
@@ -513,6 +558,7 @@ struct CacheRemoveCont: public Continuation
 // Global Data
 
 extern ClassAllocator<CacheVC> cacheVConnectionAllocator;
+extern ClassAllocator<CacheReadAhead> cacheReadAheadAllocator;
 extern CacheKey zero_key;
 extern CacheSync *cacheDirSync;
 // Function Prototypes
@@ -563,6 +609,8 @@ free_CacheVC(CacheVC *cont)
     cont->trigger->cancel();
   ink_assert(!cont->is_io_in_progress());
   ink_assert(!cont->od);
+  if (cont->read_ahead_list)
+    cont->cancel_read_ahead();
   /* calling cont->io.action = NULL causes compile problem on 2.6 solaris
      release build....wierd??? For now, null out continuation and mutex
      of the action separately */
@@ -607,6 +655,21 @@ free_CacheVC(CacheVC *cont)
   return EVENT_DONE;
 }
 
+TS_INLINE void
+free_CacheReadAhead(CacheReadAhead *ra)
+{
+  ra->io.action.continuation = NULL;
+  ra->io.action.mutex = NULL;
+  ra->io.mutex.clear();
+  ra->io.aio_result = 0;
+  ra->buf.clear();
+  ra->mutex.clear();
+  ra->vc = NULL;
+  ra->next = NULL;
+  ra->done = false;
+  cacheReadAheadAllocator.free(ra);
+}
+
 TS_INLINE int
 CacheVC::calluser(int event)
 {
@@ -36,12 +36,15 @@
 #define VOL_MAGIC                      0xF1D0F00D
 #define START_BLOCKS                    16      // 8k, STORE_BLOCK_SIZE
 #define START_POS                       ((off_t)START_BLOCKS * CACHE_BLOCK_SIZE)
-#define AGG_SIZE                        (4 * 1024 * 1024) // 4MB
-#define AGG_HIGH_WATER                  (AGG_SIZE / 2) // 2MB
+#define AGG_SIZE                        (4 * 1024 * 1024) // 4MB, default and minimum
+#define MAX_AGG_SIZE                    (64 * 1024 * 1024) // 64MB
+#define AGG_HIGH_WATER(_v)              ((_v)->agg_size / 2)
 #define EVACUATION_SIZE                 (2 * AGG_SIZE)  // 8MB
 #define MAX_VOL_SIZE                   ((off_t)512 * 1024 * 1024 * 1024 * 1024)
 #define STORE_BLOCKS_PER_CACHE_BLOCK    (STORE_BLOCK_SIZE / CACHE_BLOCK_SIZE)
 #define MAX_VOL_BLOCKS                 (MAX_VOL_SIZE / CACHE_BLOCK_SIZE)
+// a fragment must fit one agg buffer of the smallest agg_size, so the
+// limit (and the on-disk format) does not depend on the configuration
 #define MAX_FRAG_SIZE                   (AGG_SIZE - sizeofDoc) // true max
 #define LEAVE_FREE                      DEFAULT_MAX_BUFFER_SIZE
 #define PIN_SCAN_EVERY                  16      // scan every 1/16 of disk
@@ -127,6 +130,58 @@ struct EvacuationBlock
   LINK(EvacuationBlock, link);
 };
 
+// Count-min sketch of the keys of recent write attempts. Counters are
+// halved every window attempts so that old popularity fades.
+#define ADMISSION_DEPTH                 4
+#define ADMISSION_MAX_WIDTH             (1 << 22)
+
+struct CacheAdmission
+{
+  uint8_t *count;
+  uint32_t mask;                // width - 1, width a power of 2
+  int64_t samples;
+  int64_t window;
+
+  void init(int64_t entries, int64_t awindow) {
+    uint32_t width = 1024;
+    while (width < entries / 4 && width < ADMISSION_MAX_WIDTH)
+      width <<= 1;
+    mask = width - 1;
+    count = (uint8_t *)ats_malloc(ADMISSION_DEPTH * width);
+    memset(count, 0, ADMISSION_DEPTH * width);
+    samples = 0;
+    window = awindow > 0 ? awindow : entries;
+  }
+  // count an attempt for key and return the attempts seen in the window
+  int access(INK_MD5 *key) {
+    uint8_t *c[ADMISSION_DEPTH];
+    uint8_t est = 255;
+    for (int i = 0; i < ADMISSION_DEPTH; i++) {
+      c[i] = count + i * (mask + 1) + (key->word(i) & mask);
+      if (*c[i] < est)
+        est = *c[i];
+    }
+    // conservative update, only the smallest counters grow
+    if (est < 255) {
+      for (int i = 0; i < ADMISSION_DEPTH; i++)
+        if (*c[i] == est)
+          (*c[i])++;
+      est++;
+    }
+    if (++samples >= window)
+      age();
+    return est;
+  }
+  void age() {
+    for (int64_t i = 0; i < ADMISSION_DEPTH * ((int64_t) mask + 1); i++)
+      count[i] >>= 1;
+    samples /= 2;
+  }
+
+  CacheAdmission(): count(NULL), mask(0), samples(0), window(0) { }
+  ~CacheAdmission() { ats_free(count); }
+};
+
 struct Vol: public Continuation
 {
   char *path;
@@ -153,9 +208,12 @@ struct Vol: public Continuation
   Queue<CacheVC, Continuation::Link_link> agg;
   Queue<CacheVC, Continuation::Link_link> stat_cache_vcs;
   Queue<CacheVC, Continuation::Link_link> sync;
-  char *agg_buffer;
+  char *agg_buffer;             // filling
+  char *agg_flush_buffer;       // in flight, at header->write_pos
+  int agg_size;
   int agg_todo_size;
   int agg_buf_pos;
+  int agg_flush_len;
 
   Event *trigger;
 
@@ -177,12 +235,17 @@ struct Vol: public Continuation
   bool recover_wrapped;
   bool dir_sync_waiting;
   bool dir_sync_in_progress;
+  uint8_t *dir_sync_state;      // per segment DIR_SYNC_* flags
+  char *dir_sync_buf;           // snapshot being written by the dir sync
   bool writing_end_marker;
+  volatile int read_ahead_pending;  // CacheReadAhead reads outstanding on this volume
 
   CacheKey first_fragment_key;
   int64_t first_fragment_offset;
   Ptr<IOBufferData> first_fragment_data;
 
+  CacheAdmission admission;     // if cache_config_admission_threshold
+
   void cancel_trigger();
 
   int open_write(CacheVC *cont, int allow_if_writers, int max_writers);
@@ -251,21 +314,19 @@ struct Vol: public Continuation
   Vol()
     : Continuation(new_ProxyMutex()), path(NULL), fd(-1),
       dir(0), buckets(0), recover_pos(0), prev_recover_pos(0), scan_pos(0), skip(0), start(0),
-      len(0), data_blocks(0), hit_evacuate_window(0), agg_todo_size(0), agg_buf_pos(0), trigger(0),
+      len(0), data_blocks(0), hit_evacuate_window(0), agg_buffer(NULL), agg_flush_buffer(NULL),
+      agg_size(AGG_SIZE), agg_todo_size(0), agg_buf_pos(0), agg_flush_len(0), trigger(0),
       evacuate_size(0), disk(NULL), last_sync_serial(0), last_write_serial(0), recover_wrapped(false),
-      dir_sync_waiting(0), dir_sync_in_progress(0), writing_end_marker(0) {
+      dir_sync_waiting(0), dir_sync_in_progress(0), dir_sync_state(NULL),
+      dir_sync_buf(NULL), writing_end_marker(0), read_ahead_pending(0) {
     open_dir.mutex = mutex;
-#if defined(_WIN32)
-    agg_buffer = (char *)ats_malloc(AGG_SIZE);
-#else
-    agg_buffer = (char *)ats_memalign(sysconf(_SC_PAGESIZE), AGG_SIZE);
-#endif
-    memset(agg_buffer, 0, AGG_SIZE);
     SET_HANDLER(&Vol::aggWrite);
   }
 
   ~Vol() {
     ats_memalign_free(agg_buffer);
+    ats_memalign_free(agg_flush_buffer);
+    ats_free(dir_sync_state);
   }
 };
 
@@ -289,9 +350,11 @@ struct CacheVol
   LINK(CacheVol, link);
   // per volume stats
   RecRawStatBlock *vol_rsb;
+  RecRawStatBlock *ram_cache_shard_rsb;
 
   CacheVol()
-    : vol_number(-1), scheme(0), size(0), num_vols(0), vols(NULL), disk_vols(0), vol_rsb(0)
+    : vol_number(-1), scheme(0), size(0), num_vols(0), vols(NULL), disk_vols(0), vol_rsb(0),
+      ram_cache_shard_rsb(0)
   { }
 };
 
@@ -351,6 +414,14 @@ vol_dirlen(Vol *d)
     ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter));
 }
 
+// evacuate (and recover) far enough ahead of the write position to cover
+// the aggregation write in flight and the one being filled
+TS_INLINE off_t
+vol_evacuation_size(Vol *d)
+{
+  return 2 * (off_t) d->agg_size;
+}
+
 TS_INLINE int
 vol_direntries(Vol *d)
 {
@@ -366,7 +437,7 @@ vol_out_of_phase_valid(Vol *d, Dir *e)
 TS_INLINE int
 vol_out_of_phase_agg_valid(Vol *d, Dir *e)
 {
-  return (dir_offset(e) - 1 >= ((d->header->agg_pos - d->start + AGG_SIZE) / CACHE_BLOCK_SIZE));
+  return (dir_offset(e) - 1 >= ((d->header->agg_pos - d->start + d->agg_size) / CACHE_BLOCK_SIZE));
 }
 
 TS_INLINE int
@@ -378,7 +449,7 @@ vol_out_of_phase_write_valid(Vol *d, Dir *e)
 TS_INLINE int
 vol_in_phase_valid(Vol *d, Dir *e)
 {
-  return (dir_offset(e) - 1 < ((d->header->write_pos + d->agg_buf_pos - d->start) / CACHE_BLOCK_SIZE));
+  return (dir_offset(e) - 1 < ((d->header->write_pos + d->agg_flush_len + d->agg_buf_pos - d->start) / CACHE_BLOCK_SIZE));
 }
 
 TS_INLINE off_t
@@ -408,7 +479,8 @@ vol_dir_segment(Vol *d, int s)
 TS_INLINE int
 vol_in_phase_agg_buf_valid(Vol *d, Dir *e)
 {
-  return (vol_offset(d, e) >= d->header->write_pos && vol_offset(d, e) < (d->header->write_pos + d->agg_buf_pos));
+  return (vol_offset(d, e) >= d->header->write_pos &&
+          vol_offset(d, e) < (d->header->write_pos + d->agg_flush_len + d->agg_buf_pos));
 }
 
 // length of the partition not including the offset of location 0.
@@ -516,7 +588,7 @@ TS_INLINE int
 Vol::within_hit_evacuate_window(Dir *xdir)
 {
   off_t oft = dir_offset(xdir) - 1;
-  off_t write_off = (header->write_pos + AGG_SIZE - start) / CACHE_BLOCK_SIZE;
+  off_t write_off = (header->write_pos + agg_size - start) / CACHE_BLOCK_SIZE;
   off_t delta = oft - write_off;
   if (delta >= 0)
     return delta < hit_evacuate_window;
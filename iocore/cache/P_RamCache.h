@@ -34,11 +34,30 @@ struct RamCache {
   virtual int put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0) = 0;
   virtual int fixup(INK_MD5 *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2) = 0;
 
-  virtual void init(int64_t max_bytes, Vol *vol) = 0;
+  // calls are made holding mutex, the vol mutex if NULL
+  virtual void init(int64_t max_bytes, Vol *vol, ProxyMutex *mutex = NULL) = 0;
   virtual ~RamCache() {};
 };
 
 RamCache *new_RamCacheLRU();
 RamCache *new_RamCacheCLFUS();
+// n CLFUS caches compressed by one task continuation
+void new_RamCacheCLFUS_shards(RamCache **cache, int n);
+
+// Sharded Ram Cache: the cache of a vol split by key into shards of
+// the given algorithm, each with its own lock instead of the vol lock
+
+#define RAM_CACHE_MAX_SHARDS 64
+
+enum RamCacheShardStat
+{
+  ram_cache_shard_hits_stat,
+  ram_cache_shard_misses_stat,
+  ram_cache_shard_lock_contention_stat,
+  ram_cache_shard_stat_count
+};
+
+RamCache *new_RamCacheSharded(int algorithm, int nshards);
+void register_ram_cache_shard_stats(RecRawStatBlock *rsb, const char *prefix, int nshards);
 
 #endif /* _P_RAM_CACHE_H__ */
@@ -76,10 +76,11 @@ struct RamCacheCLFUS : public RamCache {
   int put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0);
   int fixup(INK_MD5 *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2);
 
-  void init(int64_t max_bytes, Vol *vol);
+  void init(int64_t max_bytes, Vol *vol, ProxyMutex *mutex = NULL);
 
   // private
   Vol *vol; // for stats
+  ProxyMutex *mutex; // held by callers, taken by compress_entries
   int64_t history;
   int ibuckets;
   int nbuckets;
@@ -88,14 +89,14 @@ struct RamCacheCLFUS : public RamCache {
   uint16_t *seen;
   int ncompressed;
   RamCacheCLFUSEntry *compressed; // first uncompressed lru[0] entry
-  void compress_entries(EThread *thread, int do_at_most = INT_MAX);
+  void compress_entries(EThread *thread, ink_hrtime *budget, int do_at_most = INT_MAX);
   void resize_hashtable();
   void victimize(RamCacheCLFUSEntry *e);
   void move_compressed(RamCacheCLFUSEntry *e);
   RamCacheCLFUSEntry *destroy(RamCacheCLFUSEntry *e);
   void requeue_victims(RamCacheCLFUS *c, Que(RamCacheCLFUSEntry, lru_link) &victims);
   void tick(); // move CLOCK on history
-  RamCacheCLFUS(): max_bytes(0), bytes(0), objects(0), vol(0), history(0), ibuckets(0), nbuckets(0), bucket(0),
+  RamCacheCLFUS(): max_bytes(0), bytes(0), objects(0), vol(0), mutex(0), history(0), ibuckets(0), nbuckets(0), bucket(0),
               seen(0), ncompressed(0), compressed(0) { }
 };
 
@@ -129,8 +130,9 @@ void RamCacheCLFUS::resize_hashtable() {
   memset(seen, 0, size);
 }
 
-void RamCacheCLFUS::init(int64_t abytes, Vol *avol) {
+void RamCacheCLFUS::init(int64_t abytes, Vol *avol, ProxyMutex *amutex) {
   vol = avol;
+  mutex = amutex ? amutex : (ProxyMutex *) avol->mutex;
   max_bytes = abytes;
   DDebug("ram_cache", "initializing ram_cache %" PRId64 " bytes", abytes);
   if (!max_bytes)
@@ -168,6 +170,7 @@ int RamCacheCLFUS::get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxke
         e->hits++;
         if (e->flag_bits.compressed) {
           b = (char*)ats_malloc(e->len);
+          ink_hrtime start = ink_get_hrtime_internal();
           switch (e->flag_bits.compressed) {
             default: goto Lfailed;
             case CACHE_COMPRESSION_FASTLZ: {
@@ -195,6 +198,7 @@ int RamCacheCLFUS::get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxke
             }
 #endif
           }
+          CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_decompress_time_stat, ink_get_hrtime_internal() - start);
           IOBufferData *data = new_xmalloc_IOBufferData(b, e->len);
           data->_mem_type = DEFAULT_ALLOC;
           if (!e->flag_bits.copy) { // don't bother if we have to copy anyway
@@ -298,10 +302,11 @@ RamCacheCLFUSEntry *RamCacheCLFUS::destroy(RamCacheCLFUSEntry *e) {
   return ret;
 }
 
-void RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most) {
+// compresses until the entries or the CPU time in budget run out
+void RamCacheCLFUS::compress_entries(EThread *thread, ink_hrtime *budget, int do_at_most) {
   if (!cache_config_ram_cache_compress)
     return;
-  MUTEX_TAKE_LOCK(vol->mutex, thread);
+  MUTEX_TAKE_LOCK(mutex, thread);
   if (!compressed) {
     compressed = lru[0].head;
     ncompressed = 0;
@@ -313,9 +318,9 @@ void RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most) {
     RamCacheCLFUSEntry *e = compressed;
     if (e->flag_bits.incompressible || e->flag_bits.compressed)
       goto Lcontinue;
-    n++;
-    if (do_at_most < n)
+    if (n >= do_at_most || *budget <= 0)
       break;
+    n++;
     {
       e->compressed_len = e->size;
       uint32_t l = 0;
@@ -334,7 +339,8 @@ void RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most) {
       Ptr<IOBufferData> edata = e->data;
       uint32_t elen = e->len;
       INK_MD5 key = e->key;
-      MUTEX_UNTAKE_LOCK(vol->mutex, thread);
+      MUTEX_UNTAKE_LOCK(mutex, thread);
+      ink_hrtime start = ink_get_hrtime_internal();
       b = (char*)ats_malloc(l);
       bool failed = false;
       switch (ctype) {
@@ -364,7 +370,8 @@ void RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most) {
         }
 #endif
       }
-      MUTEX_TAKE_LOCK(vol->mutex, thread);
+      *budget -= ink_get_hrtime_internal() - start;
+      MUTEX_TAKE_LOCK(mutex, thread);
       // see if the entry is till around
       {
         uint32_t i = key.word(3) % nbuckets;
@@ -386,6 +393,9 @@ void RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most) {
         goto Lfailed;
       if (l < e->len) {
         e->flag_bits.compressed = cache_config_ram_cache_compress;
+        CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_compress_bytes_in_stat, e->len);
+        CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_compress_bytes_saved_stat, e->len - l);
+        CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_compress_ratio_stat, (int64_t) l * 100 / e->len);
         bb = (char*)ats_malloc(l);
         memcpy(bb, b, l);
         ats_free(b);
@@ -423,7 +433,7 @@ void RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most) {
     compressed = e->lru_link.next;
     ncompressed++;
   }
-  MUTEX_UNTAKE_LOCK(vol->mutex, thread);
+  MUTEX_UNTAKE_LOCK(mutex, thread);
   return;
 }
 
@@ -609,10 +619,13 @@ int RamCacheCLFUS::fixup(INK_MD5 * key, uint32_t old_auxkey1, uint32_t old_auxke
   return 0;
 }
 
+// compresses the entries of one or more caches, e.g. the shards of a vol
 class RamCacheCLFUSCompressor : public Continuation { public:
-  RamCacheCLFUS *rc;
+  RamCacheCLFUS **rc;
+  int nrc;
+  int next; // the cache to start with
   int mainEvent(int event, Event *e);
-  RamCacheCLFUSCompressor(RamCacheCLFUS *arc): rc(arc) { 
+  RamCacheCLFUSCompressor(RamCacheCLFUS **arc, int anrc): rc(arc), nrc(anrc), next(0) {
    SET_HANDLER(&RamCacheCLFUSCompressor::mainEvent); 
   }
 };
@@ -636,14 +649,27 @@ int RamCacheCLFUSCompressor::mainEvent(int event, Event *e) {
 #endif
       break;
   }
-  if (cache_config_ram_cache_compress_percent)
-    rc->compress_entries(e->ethread);
+  if (cache_config_ram_cache_compress_percent) {
+    // called every second, limit the share of the task thread used by
+    // all the caches together
+    ink_hrtime budget = HRTIME_SECOND / 100 * cache_config_ram_cache_compress_cpu_percent;
+    for (int i = 0; i < nrc && budget > 0; i++)
+      rc[(next + i) % nrc]->compress_entries(e->ethread, &budget);
+    next = (next + 1) % nrc;
+  }
   return EVENT_CONT;
 }
 
-RamCache *new_RamCacheCLFUS() {
-  RamCacheCLFUS *r = new RamCacheCLFUS;
-  eventProcessor.schedule_every(new RamCacheCLFUSCompressor(r), HRTIME_SECOND,
+void new_RamCacheCLFUS_shards(RamCache **cache, int n) {
+  RamCacheCLFUS **r = new RamCacheCLFUS *[n];
+  for (int i = 0; i < n; i++)
+    cache[i] = r[i] = new RamCacheCLFUS;
+  eventProcessor.schedule_every(new RamCacheCLFUSCompressor(r, n), HRTIME_SECOND,
     ET_TASK);
+}
+
+RamCache *new_RamCacheCLFUS() {
+  RamCache *r;
+  new_RamCacheCLFUS_shards(&r, 1);
   return r;
 }
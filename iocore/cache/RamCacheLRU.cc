@@ -42,7 +42,7 @@ struct RamCacheLRU: public RamCache {
   int put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0);
   int fixup(INK_MD5 *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2);
 
-  void init(int64_t max_bytes, Vol *vol);
+  void init(int64_t max_bytes, Vol *vol, ProxyMutex *mutex = NULL);
 
   // private
   uint16_t *seen;
@@ -91,7 +91,8 @@ void RamCacheLRU::resize_hashtable() {
 }
 
 void
-RamCacheLRU::init(int64_t abytes, Vol *avol) {
+RamCacheLRU::init(int64_t abytes, Vol *avol, ProxyMutex *amutex) {
+  NOWARN_UNUSED(amutex);
   vol = avol;
   max_bytes = abytes;
   DDebug("ram_cache", "initializing ram_cache %" PRId64 " bytes", abytes);
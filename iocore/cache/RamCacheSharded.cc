@@ -0,0 +1,140 @@
+/** @file
+
+  A brief file description
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "P_Cache.h"
+
+// The RAM cache of a vol split by key into shards, each with its own
+// lock, so that RAM cache operations, and in particular compression
+// on the task threads, do not serialize on the vol lock.
+// get() and put() are called without the vol lock and wait for the
+// shard; the CLFUS shards share one compressor.
+
+struct RamCacheShard {
+  Ptr<ProxyMutex> mutex;
+  RamCache *cache;
+};
+
+struct RamCacheSharded: public RamCache {
+  // returns 1 on found/stored, 0 on not found/stored, if provided auxkey1 and auxkey2 must match
+  int get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0);
+  int put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0);
+  int fixup(INK_MD5 *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2);
+
+  void init(int64_t max_bytes, Vol *vol, ProxyMutex *mutex = NULL);
+
+  // private
+  int nshards;
+  RamCacheShard *shard;
+  RecRawStatBlock *rsb; // per shard stats of the cache volume
+
+  int lock(INK_MD5 *key, EThread *thread);
+  void stat(int i, int x, EThread *thread) {
+    if (rsb)
+      RecIncrRawStat(rsb, thread, i * ram_cache_shard_stat_count + x, 1);
+  }
+
+  RamCacheSharded(int algorithm, int n);
+  ~RamCacheSharded();
+};
+
+RamCacheSharded::RamCacheSharded(int algorithm, int n): nshards(n), rsb(NULL) {
+  RamCache *cache[RAM_CACHE_MAX_SHARDS];
+  shard = new RamCacheShard[nshards];
+  if (algorithm != RAM_CACHE_ALGORITHM_LRU)
+    new_RamCacheCLFUS_shards(cache, nshards);
+  for (int i = 0; i < nshards; i++) {
+    shard[i].mutex = new_ProxyMutex();
+    shard[i].cache = algorithm == RAM_CACHE_ALGORITHM_LRU ? new_RamCacheLRU() : cache[i];
+  }
+}
+
+RamCacheSharded::~RamCacheSharded() {
+  for (int i = 0; i < nshards; i++)
+    delete shard[i].cache;
+  delete[] shard;
+}
+
+void RamCacheSharded::init(int64_t abytes, Vol *avol, ProxyMutex *amutex) {
+  NOWARN_UNUSED(amutex);
+  rsb = avol->cache_vol ? avol->cache_vol->ram_cache_shard_rsb : NULL;
+  DDebug("ram_cache", "initializing %d ram_cache shards of %" PRId64 " bytes", nshards, abytes / nshards);
+  for (int i = 0; i < nshards; i++)
+    shard[i].cache->init(abytes / nshards, avol, shard[i].mutex);
+}
+
+// word(0), word(1) and word(2) pick the dir segment, bucket and tag
+// and the vol; the inner caches hash word(3) modulo a prime, which
+// stays uniform within a shard
+static inline int shard_index(INK_MD5 *key, int nshards) {
+  return key->word(3) % nshards;
+}
+
+// returns the shard of key, locked
+int RamCacheSharded::lock(INK_MD5 *key, EThread *thread) {
+  int i = shard_index(key, nshards);
+  if (!MUTEX_TAKE_TRY_LOCK(shard[i].mutex, thread)) {
+    stat(i, ram_cache_shard_lock_contention_stat, thread);
+    MUTEX_TAKE_LOCK(shard[i].mutex, thread);
+  }
+  return i;
+}
+
+int RamCacheSharded::get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1, uint32_t auxkey2) {
+  EThread *thread = this_ethread();
+  int i = lock(key, thread);
+  int res = shard[i].cache->get(key, ret_data, auxkey1, auxkey2);
+  MUTEX_UNTAKE_LOCK(shard[i].mutex, thread);
+  stat(i, res ? ram_cache_shard_hits_stat : ram_cache_shard_misses_stat, thread);
+  return res;
+}
+
+int RamCacheSharded::put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool copy, uint32_t auxkey1, uint32_t auxkey2) {
+  EThread *thread = this_ethread();
+  int i = lock(key, thread);
+  int res = shard[i].cache->put(key, data, len, copy, auxkey1, auxkey2);
+  MUTEX_UNTAKE_LOCK(shard[i].mutex, thread);
+  return res;
+}
+
+int RamCacheSharded::fixup(INK_MD5 * key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2) {
+  EThread *thread = this_ethread();
+  int i = lock(key, thread);
+  int res = shard[i].cache->fixup(key, old_auxkey1, old_auxkey2, new_auxkey1, new_auxkey2);
+  MUTEX_UNTAKE_LOCK(shard[i].mutex, thread);
+  return res;
+}
+
+void register_ram_cache_shard_stats(RecRawStatBlock *rsb, const char *prefix, int nshards) {
+  static const char *names[ram_cache_shard_stat_count] = { "hits", "misses", "lock_contention" };
+  char stat_str[256];
+  for (int i = 0; i < nshards; i++)
+    for (int x = 0; x < ram_cache_shard_stat_count; x++) {
+      snprintf(stat_str, sizeof(stat_str), "%s.ram_cache.shard_%d.%s", prefix, i, names[x]);
+      RecRegisterRawStat(rsb, RECT_PROCESS, stat_str, RECD_INT, RECP_NON_PERSISTENT,
+                         i * ram_cache_shard_stat_count + x, RecRawStatSyncSum);
+    }
+}
+
+RamCache *new_RamCacheSharded(int algorithm, int nshards) {
+  return new RamCacheSharded(algorithm, nshards);
+}
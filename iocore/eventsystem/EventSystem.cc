@@ -30,13 +30,123 @@
 
 #include "P_EventSystem.h"
 
+static RecRawStatBlock *hugepage_rsb = NULL;
+
+static int
+hugepage_stats_cb(const char *name, RecDataT data_type, RecData *data, RecRawStatBlock *rsb, int id)
+{
+  int64_t v = 0;
+
+  switch (id) {
+  case 0:
+    v = ats_hugepage_hugetlb_bytes;
+    break;
+  case 1:
+    v = ats_hugepage_thp_bytes;
+    break;
+  default:
+    v = ats_hugepage_fallbacks;
+    break;
+  }
+  RecSetGlobalRawStatSum(rsb, id, v);
+  return RecRawStatSyncSum(name, data_type, data, rsb, id);
+}
+
+static RecRawStatBlock *eventloop_rsb = NULL;
+
+enum
+{
+  eventloop_idle_stat,
+  eventloop_spin_stat,
+  eventloop_busy_stat,
+  eventloop_spin_hits_stat,
+  eventloop_spin_misses_stat,
+  eventloop_wakeup_latency_stat,        // ETHREAD_WAKEUP_BUCKETS of them
+  eventloop_stat_count = eventloop_wakeup_latency_stat + ETHREAD_WAKEUP_BUCKETS
+};
+
+static const char *eventloop_wakeup_latency_name[ETHREAD_WAKEUP_BUCKETS] = {
+  "10us", "50us", "100us", "500us", "1ms", "over_1ms"
+};
+
+// Sums over all regular event threads; times are in microseconds.
+static int
+eventloop_stats_cb(const char *name, RecDataT data_type, RecData *data, RecRawStatBlock *rsb, int id)
+{
+  ink_hrtime now = ink_get_hrtime_internal();
+  int64_t v = 0;
+
+  for (int i = 0; i < eventProcessor.n_ethreads; i++) {
+    EThreadLoopStats *s = &eventProcessor.all_ethreads[i]->loop_stats;
+    if (!s->started)
+      continue;
+    switch (id) {
+    case eventloop_idle_stat:
+      v += s->idle_time / HRTIME_USECOND;
+      break;
+    case eventloop_spin_stat:
+      v += s->spin_time / HRTIME_USECOND;
+      break;
+    case eventloop_busy_stat:
+      v += (now - s->started - s->idle_time - s->spin_time) / HRTIME_USECOND;
+      break;
+    case eventloop_spin_hits_stat:
+      v += s->spin_hits;
+      break;
+    case eventloop_spin_misses_stat:
+      v += s->spin_misses;
+      break;
+    default:
+      v += s->wakeup_latency[id - eventloop_wakeup_latency_stat];
+      break;
+    }
+  }
+  RecSetGlobalRawStatSum(rsb, id, v);
+  return RecRawStatSyncSum(name, data_type, data, rsb, id);
+}
+
+static void
+register_eventloop_stats()
+{
+  char name[128];
+
+  eventloop_rsb = RecAllocateRawStatBlock(eventloop_stat_count);
+  RecRegisterRawStat(eventloop_rsb, RECT_PROCESS, "proxy.process.eventloop.idle_usec",
+                     RECD_INT, RECP_NON_PERSISTENT, eventloop_idle_stat, eventloop_stats_cb);
+  RecRegisterRawStat(eventloop_rsb, RECT_PROCESS, "proxy.process.eventloop.spin_usec",
+                     RECD_INT, RECP_NON_PERSISTENT, eventloop_spin_stat, eventloop_stats_cb);
+  RecRegisterRawStat(eventloop_rsb, RECT_PROCESS, "proxy.process.eventloop.busy_usec",
+                     RECD_INT, RECP_NON_PERSISTENT, eventloop_busy_stat, eventloop_stats_cb);
+  RecRegisterRawStat(eventloop_rsb, RECT_PROCESS, "proxy.process.eventloop.spin_hits",
+                     RECD_INT, RECP_NON_PERSISTENT, eventloop_spin_hits_stat, eventloop_stats_cb);
+  RecRegisterRawStat(eventloop_rsb, RECT_PROCESS, "proxy.process.eventloop.spin_misses",
+                     RECD_INT, RECP_NON_PERSISTENT, eventloop_spin_misses_stat, eventloop_stats_cb);
+  for (int i = 0; i < ETHREAD_WAKEUP_BUCKETS; i++) {
+    snprintf(name, sizeof(name), "proxy.process.eventloop.wakeup_latency.%s", eventloop_wakeup_latency_name[i]);
+    RecRegisterRawStat(eventloop_rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT,
+                       eventloop_wakeup_latency_stat + i, eventloop_stats_cb);
+  }
+}
+
 void
 ink_event_system_init(ModuleVersion v)
 {
   ink_release_assert(!checkModuleVersion(v, EVENT_SYSTEM_MODULE_VERSION));
   int config_max_iobuffer_size = DEFAULT_MAX_BUFFER_SIZE;
+  int hugepages = 0;
 
   IOCORE_ReadConfigInteger(config_max_iobuffer_size, "proxy.config.io.max_buffer_size");
+  IOCORE_ReadConfigInteger(hugepages, "proxy.config.allocator.hugepages");
+  ats_hugepage_init(hugepages);
+  if (hugepages) {
+    hugepage_rsb = RecAllocateRawStatBlock(3);
+    RecRegisterRawStat(hugepage_rsb, RECT_PROCESS, "proxy.process.allocator.hugepages.hugetlb_bytes",
+                       RECD_INT, RECP_NON_PERSISTENT, 0, hugepage_stats_cb);
+    RecRegisterRawStat(hugepage_rsb, RECT_PROCESS, "proxy.process.allocator.hugepages.thp_bytes",
+                       RECD_INT, RECP_NON_PERSISTENT, 1, hugepage_stats_cb);
+    RecRegisterRawStat(hugepage_rsb, RECT_PROCESS, "proxy.process.allocator.hugepages.fallbacks",
+                       RECD_INT, RECP_NON_PERSISTENT, 2, hugepage_stats_cb);
+  }
 
   max_iobuffer_size = buffer_size_to_index(config_max_iobuffer_size, DEFAULT_BUFFER_SIZES - 1);
   if (default_small_iobuffer_size > max_iobuffer_size)
@@ -44,4 +154,5 @@ ink_event_system_init(ModuleVersion v)
   if (default_large_iobuffer_size > max_iobuffer_size)
     default_large_iobuffer_size = max_iobuffer_size;
   init_buffer_allocators();
+  register_eventloop_stats();
 }
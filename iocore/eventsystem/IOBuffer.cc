@@ -57,7 +57,7 @@ init_buffer_allocators()
 
     name = NEW(new char[64]);
     snprintf(name, 64, "ioBufAllocator[%d]", i);
-    ioBufAllocator[i].re_init(name, s, n, a);
+    ioBufAllocator[i].re_init(name, s, n, a, ats_hugepage_enabled());
   }
 }
 
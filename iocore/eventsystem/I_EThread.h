@@ -61,6 +61,22 @@ enum teThreadType {
   keSpawnThread
 };
 
+/** Upper bounds of the wakeup latency histogram buckets, the last
+    bucket takes everything above. */
+#define ETHREAD_WAKEUP_BUCKETS 6
+extern const ink_hrtime ethread_wakeup_bucket_limit[ETHREAD_WAKEUP_BUCKETS - 1];
+
+/** Where an event thread spends its time, written by that thread only. */
+struct EThreadLoopStats
+{
+  ink_hrtime started;           ///< when the thread entered execute()
+  ink_hrtime idle_time;         ///< blocked waiting for events
+  ink_hrtime spin_time;         ///< spinning before sleeping
+  int64_t spin_hits;
+  int64_t spin_misses;
+  int64_t wakeup_latency[ETHREAD_WAKEUP_BUCKETS];
+};
+
 /**
   Event System specific type of thread.
 
@@ -322,6 +338,8 @@ public:
 
   int id;
   unsigned int event_types;
+  /** Processor this thread is bound to, -1 if it is not bound to a single one. */
+  int cpu;
   bool is_event_type(EventType et);
   void set_event_type(EventType et);
 #if defined(USE_OLD_EVENTFD)
@@ -332,6 +350,7 @@ public:
   void execute();
   void process_event(Event *e, int calling_code);
   void free_event(Event *e);
+  Event *steal_event();
   void (*signal_hook)(EThread *);
 
 #if TS_HAS_EVENTFD
@@ -341,6 +360,28 @@ public:
 #endif
   EventIO *ep;
 
+  /** Set while this thread is waiting for events, in dequeue_timed or
+      its poll.  Producers only wake a thread which is idle. */
+  volatile int idle;
+  void sleep_begin();
+  void wakeup();
+  /** Number of events this thread has stolen from busy siblings. */
+  volatile int64_t steal_count;
+
+  /** Spin for up to spin_budget before sleeping.  The budget doubles
+      when a spin finds work and halves, down to spin_max / 16, when it
+      does not.  spin_max 0 disables spinning. */
+  ink_hrtime spin_max;
+  ink_hrtime spin_budget;
+  /** Extra readiness check while spinning, e.g. a non-blocking poll. */
+  int (*spin_hook)(EThread *);
+  bool spin_wait(ink_hrtime deadline);
+  void sleep_end();
+  /** Set by the producer which woke this thread, for wakeup latency. */
+  volatile ink_hrtime wakeup_at;
+  ink_hrtime sleep_start;
+  EThreadLoopStats loop_stats;
+
   ThreadType tt;
   Event *oneevent;              // For dedicated event thread
   ink_sem *eventsem;            // For dedicated event thread
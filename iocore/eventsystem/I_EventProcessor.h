@@ -253,6 +253,27 @@ public:
   */
   off_t allocate(int size);
 
+  /**
+    Allow idle threads of an event type to steal immediate events
+    queued on their busy siblings. Only for thread groups whose
+    continuations do not depend on running on the thread they were
+    assigned to.
+
+    @param etype thread group id (or event type) to enable.
+
+  */
+  void enable_work_stealing(EventType etype);
+
+  /**
+    Let the threads of a group spin for up to spin before they go to
+    sleep waiting for events, see EThread::spin_wait().
+
+    @param etype thread group id (or event type).
+    @param spin longest spin, 0 to never spin.
+
+  */
+  void set_spin(EventType etype, ink_hrtime spin);
+
   /**
     An array of pointers to all of the EThreads handled by the
     EventProcessor. An array of pointers to all of the EThreads created
@@ -274,6 +295,9 @@ public:
   unsigned int next_thread_for_type[MAX_EVENT_TYPES];
   int n_threads_for_type[MAX_EVENT_TYPES];
 
+  /** Bit mask of the event types with work stealing enabled. */
+  unsigned int work_stealing_types;
+
   /**
     Total number of threads controlled by this EventProcessor.  This is
     the count of all the EThreads spawn by this EventProcessor, excluding
@@ -47,10 +47,18 @@ struct ProtectedQueue
   Event *dequeue_local();
   void dequeue_timed(ink_hrtime cur_time, ink_hrtime timeout, bool sleep);
 
+  // Immediate events which idle threads of the same type may steal.
+  // Protected by lock, the owner takes from the head, thieves from the tail.
+  int enqueue_stealable(Event * e, bool fast_signal = false);
+  Event *dequeue_stealable();
+  Event *steal();
+
   InkAtomicList al;
   ink_mutex lock;
   ink_cond might_have_data;
   Que(Event, link) localQueue;
+  Que(Event, link) stealQueue;
+  volatile int steal_depth;
 
   ProtectedQueue();
 };
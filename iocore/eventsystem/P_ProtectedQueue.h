@@ -35,6 +35,7 @@
 
 TS_INLINE
 ProtectedQueue::ProtectedQueue()
+  : steal_depth(0)
 {
   Event e;
   ink_mutex_init(&lock, "ProtectedQueue");
@@ -77,8 +78,21 @@ TS_INLINE void
 ProtectedQueue::remove(Event * e)
 {
   ink_assert(e->in_the_prot_queue);
-  if (!ink_atomiclist_remove(&al, e))
+  if (!ink_atomiclist_remove(&al, e)) {
+    if (steal_depth) {
+      ink_mutex_acquire(&lock);
+      for (Event *s = stealQueue.head; s; s = s->link.next)
+        if (s == e) {
+          stealQueue.remove(e);
+          steal_depth--;
+          ink_mutex_release(&lock);
+          e->in_the_prot_queue = 0;
+          return;
+        }
+      ink_mutex_release(&lock);
+    }
     localQueue.remove(e);
+  }
   e->in_the_prot_queue = 0;
 }
 
@@ -93,4 +107,20 @@ ProtectedQueue::dequeue_local()
   return e;
 }
 
+TS_INLINE Event *
+ProtectedQueue::dequeue_stealable()
+{
+  if (!steal_depth)
+    return NULL;
+  ink_mutex_acquire(&lock);
+  Event *e = stealQueue.dequeue();
+  if (e) {
+    steal_depth--;
+    ink_assert(e->in_the_prot_queue);
+    e->in_the_prot_queue = 0;
+  }
+  ink_mutex_release(&lock);
+  return e;
+}
+
 #endif
@@ -171,6 +171,51 @@ EThread::free_event(Event * e)
   EVENT_FREE(e, eventAllocator, this);
 }
 
+// Mark this thread idle before it checks its queue one last time and
+// sleeps.  The swap orders the store before that check, and the push
+// onto EventQueueExternal.al orders a producer's check of idle after
+// its event is visible, so either we see the event or they see us idle.
+TS_INLINE void
+EThread::sleep_begin()
+{
+  wakeup_at = 0;
+  sleep_start = ink_get_hrtime_internal();
+  ink_atomic_swap(&idle, 1);
+}
+
+// Back from waiting: account the idle time and, if a producer woke us,
+// how long that took.
+TS_INLINE void
+EThread::sleep_end()
+{
+  ink_hrtime now = ink_get_hrtime_internal();
+  ink_hrtime woken = wakeup_at;
+
+  idle = 0;
+  loop_stats.idle_time += now - sleep_start;
+  if (woken && now >= woken) {
+    int i = 0;
+    while (i < ETHREAD_WAKEUP_BUCKETS - 1 && now - woken > ethread_wakeup_bucket_limit[i])
+      i++;
+    loop_stats.wakeup_latency[i]++;
+  }
+}
+
+// Wake this thread if it is sleeping: through signal_hook if it has one
+// (net threads, an eventfd in their poll set), else the condition
+// variable of its queue.  Free when the thread is busy.
+TS_INLINE void
+EThread::wakeup()
+{
+  if (!idle)
+    return;
+  wakeup_at = ink_get_hrtime_internal();
+  if (signal_hook)
+    signal_hook(this);
+  else
+    EventQueueExternal.signal();
+}
+
 #if defined(USE_OLD_EVENTFD)
 TS_INLINE int
 EThread::getEventFd()
@@ -30,6 +30,7 @@ const int LOAD_BALANCE_INTERVAL = 1;
 
 TS_INLINE
 EventProcessor::EventProcessor():
+work_stealing_types(0),
 n_ethreads(0),
 n_thread_groups(0),
 n_dthreads(0),
@@ -80,10 +81,41 @@ EventProcessor::schedule(Event * e, EventType etype, bool fast_signal)
     e->mutex = e->continuation->mutex;
   else
     e->mutex = e->continuation->mutex = e->ethread->mutex;
+  // Immediate events which are not bound to the thread's own mutex may
+  // be run by an idle sibling.  If this one is backing up, wake one.
+  if ((work_stealing_types & (1 << etype)) && e->immediate && e->mutex.m_ptr != e->ethread->mutex) {
+    if (e->ethread->EventQueueExternal.enqueue_stealable(e, fast_signal) > 1) {
+      for (int i = 0; i < n_threads_for_type[etype]; i++) {
+        EThread *t = eventthread[etype][i];
+        if (t != e->ethread && t->idle) {
+          t->wakeup();
+          break;
+        }
+      }
+    }
+    return e;
+  }
   e->ethread->EventQueueExternal.enqueue(e, fast_signal);
   return e;
 }
 
+TS_INLINE void
+EventProcessor::enable_work_stealing(EventType etype)
+{
+  ink_assert(etype < MAX_EVENT_TYPES);
+  work_stealing_types |= (1 << etype);
+}
+
+TS_INLINE void
+EventProcessor::set_spin(EventType etype, ink_hrtime spin)
+{
+  ink_assert(etype < MAX_EVENT_TYPES);
+  for (int i = 0; i < n_threads_for_type[etype]; i++) {
+    EThread *t = eventthread[etype][i];
+    t->spin_max = t->spin_budget = spin;
+  }
+}
+
 
 TS_INLINE Event *
 EventProcessor::schedule_imm_signal(Continuation * cont, EventType et, int callback_event, void *cookie)
@@ -57,22 +57,14 @@ ProtectedQueue::enqueue(Event *e , bool fast_signal)
     // queue e->ethread in the list of threads to be signalled
     // inserting_thread == 0 means it is not a regular EThread
     if (inserting_thread != e_ethread) {
-      if (!inserting_thread || !inserting_thread->ethreads_to_be_signalled) {
-        signal();
-        if (fast_signal) {
-          if (e_ethread->signal_hook)
-            e_ethread->signal_hook(e_ethread);
-        }
-      } else {
+      if (fast_signal || !inserting_thread || !inserting_thread->ethreads_to_be_signalled) {
+        e_ethread->wakeup();
+      } else if (e_ethread->idle) {
 #ifdef EAGER_SIGNALLING
         // Try to signal now and avoid deferred posting.
-        if (e_ethread->EventQueueExternal.try_signal())
+        if (!e_ethread->signal_hook && e_ethread->EventQueueExternal.try_signal())
           return;
 #endif
-        if (fast_signal) {
-          if (e_ethread->signal_hook)
-            e_ethread->signal_hook(e_ethread);
-        }
         int &t = inserting_thread->n_ethreads_to_be_signalled;
         EThread **sig_e = inserting_thread->ethreads_to_be_signalled;
         if ((t + 1) >= eventProcessor.n_ethreads) {
@@ -120,23 +112,57 @@ flush_signals(EThread * thr)
 #ifdef EAGER_SIGNALLING
   for (i = 0; i < n; i++) {
     // Try to signal as many threads as possible without blocking.
-    if (thr->ethreads_to_be_signalled[i]) {
-      if (thr->ethreads_to_be_signalled[i]->EventQueueExternal.try_signal())
-        thr->ethreads_to_be_signalled[i] = 0;
-    }
+    EThread *t = thr->ethreads_to_be_signalled[i];
+    if (t && !t->signal_hook && t->EventQueueExternal.try_signal())
+      thr->ethreads_to_be_signalled[i] = 0;
   }
 #endif
   for (i = 0; i < n; i++) {
     if (thr->ethreads_to_be_signalled[i]) {
-      thr->ethreads_to_be_signalled[i]->EventQueueExternal.signal();
-      if (thr->ethreads_to_be_signalled[i]->signal_hook)
-        thr->ethreads_to_be_signalled[i]->signal_hook(thr->ethreads_to_be_signalled[i]);
+      thr->ethreads_to_be_signalled[i]->wakeup();
       thr->ethreads_to_be_signalled[i] = 0;
     }
   }
   thr->n_ethreads_to_be_signalled = 0;
 }
 
+// Queue an immediate event which idle threads of the same type may
+// steal. Returns the number of events now waiting.
+int
+ProtectedQueue::enqueue_stealable(Event *e, bool fast_signal)
+{
+  ink_assert(!e->in_the_prot_queue && !e->in_the_priority_queue);
+  EThread *e_ethread = e->ethread;
+  e->in_the_prot_queue = 1;
+  ink_mutex_acquire(&lock);
+  stealQueue.enqueue(e);
+  int depth = ++steal_depth;
+  // Signal under the lock so the owner can't miss it in dequeue_timed.
+  if (this_ethread() != e_ethread)
+    ink_cond_signal(&might_have_data);
+  ink_mutex_release(&lock);
+  if (fast_signal && e_ethread->signal_hook)
+    e_ethread->signal_hook(e_ethread);
+  return depth;
+}
+
+Event *
+ProtectedQueue::steal()
+{
+  Event *e = NULL;
+  if (!steal_depth)
+    return NULL;
+  if (!ink_mutex_try_acquire(&lock))
+    return NULL;
+  if ((e = stealQueue.tail)) {
+    stealQueue.remove(e);
+    steal_depth--;
+    e->in_the_prot_queue = 0;
+  }
+  ink_mutex_release(&lock);
+  return e;
+}
+
 void
 ProtectedQueue::dequeue_timed(ink_hrtime cur_time, ink_hrtime timeout, bool sleep)
 {
@@ -144,7 +170,7 @@ ProtectedQueue::dequeue_timed(ink_hrtime cur_time, ink_hrtime timeout, bool slee
   Event *e;
   if (sleep) {
     ink_mutex_acquire(&lock);
-    if (INK_ATOMICLIST_EMPTY(al)) {
+    if (INK_ATOMICLIST_EMPTY(al) && !steal_depth) {
       timespec ts = ink_based_hrtime_to_timespec(timeout);
       ink_cond_timedwait(&might_have_data, &lock, &ts);
     }
@@ -22,15 +22,48 @@
  */
 
 #include "I_Tasks.h"
+#include "P_EventSystem.h"
 
 // Globals
 EventType ET_TASK = ET_CALL;
 TasksProcessor tasksProcessor;
 
+static RecRawStatBlock *task_rsb = NULL;
+
+// Two stats per task thread: the depth of its stealable queue and the
+// number of events it has stolen.
+static int
+task_stats_cb(const char *name, RecDataT data_type, RecData *data, RecRawStatBlock *rsb, int id)
+{
+  EThread *t = eventProcessor.eventthread[ET_TASK][id / 2];
+
+  RecSetGlobalRawStatSum(rsb, id, (id & 1) ? t->steal_count : t->EventQueueExternal.steal_depth);
+  return RecRawStatSyncSum(name, data_type, data, rsb, id);
+}
+
 int
 TasksProcessor::start(int task_threads)
 {
-  if (task_threads > 0)
+  if (task_threads > 0) {
+    int work_stealing = 0;
+    char name[128];
+
     ET_TASK = eventProcessor.spawn_event_threads(task_threads, "ET_TASK");
+    IOCORE_ReadConfigInteger(work_stealing, "proxy.config.task_threads.work_stealing");
+    if (work_stealing && task_threads > 1)
+      eventProcessor.enable_work_stealing(ET_TASK);
+    int spin_usec = 0;
+    IOCORE_ReadConfigInteger(spin_usec, "proxy.config.task_threads.spin_usec");
+    if (spin_usec > 0)
+      eventProcessor.set_spin(ET_TASK, HRTIME_USECONDS(spin_usec));
+
+    task_rsb = RecAllocateRawStatBlock(task_threads * 2);
+    for (int i = 0; i < task_threads; i++) {
+      snprintf(name, sizeof(name), "proxy.process.task_threads.%d.queue_depth", i);
+      RecRegisterRawStat(task_rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, i * 2, task_stats_cb);
+      snprintf(name, sizeof(name), "proxy.process.task_threads.%d.steals", i);
+      RecRegisterRawStat(task_rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, i * 2 + 1, task_stats_cb);
+    }
+  }
   return 0;
 }
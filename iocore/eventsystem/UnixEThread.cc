@@ -40,26 +40,44 @@ struct AIOCallback;
 #define THREAD_MAX_HEARTBEAT_MSECONDS	60
 #define NO_ETHREAD_ID                   -1
 
+const ink_hrtime ethread_wakeup_bucket_limit[ETHREAD_WAKEUP_BUCKETS - 1] = {
+  HRTIME_USECONDS(10), HRTIME_USECONDS(50), HRTIME_USECONDS(100), HRTIME_USECONDS(500), HRTIME_MSECONDS(1)
+};
+
 EThread::EThread()
   : generator((uint64_t)ink_get_hrtime_internal() ^ (uint64_t)(uintptr_t)this),
+   diskHandler(NULL),
    ethreads_to_be_signalled(NULL),
    n_ethreads_to_be_signalled(0),
    main_accept_index(-1),
-   id(NO_ETHREAD_ID), event_types(0),
-   signal_hook(0),
+   id(NO_ETHREAD_ID), event_types(0), cpu(-1),
+   signal_hook(0), ep(NULL),
+   idle(0), steal_count(0),
+   spin_max(0), spin_budget(0), spin_hook(0), wakeup_at(0), sleep_start(0),
    tt(REGULAR), eventsem(NULL)
 {
   memset(thread_private, 0, PER_THREAD_DATA);
+  ink_zero(loop_stats);
 }
 
 EThread::EThread(ThreadType att, int anid)
   : generator((uint64_t)ink_get_hrtime_internal() ^ (uint64_t)(uintptr_t)this),
+    diskHandler(NULL),
     ethreads_to_be_signalled(NULL),
     n_ethreads_to_be_signalled(0),
     main_accept_index(-1),
     id(anid),
     event_types(0),
+    cpu(-1),
     signal_hook(0),
+    ep(NULL),
+    idle(0),
+    steal_count(0),
+    spin_max(0),
+    spin_budget(0),
+    spin_hook(0),
+    wakeup_at(0),
+    sleep_start(0),
     tt(att),
     eventsem(NULL),
     l1_hash(NULL)
@@ -67,6 +85,7 @@ EThread::EThread(ThreadType att, int anid)
   ethreads_to_be_signalled = (EThread **)ats_malloc(MAX_EVENT_THREADS * sizeof(EThread *));
   memset((char *) ethreads_to_be_signalled, 0, MAX_EVENT_THREADS * sizeof(EThread *));
   memset(thread_private, 0, PER_THREAD_DATA);
+  ink_zero(loop_stats);
 #if TS_HAS_EVENTFD
   evfd = eventfd(0, O_NONBLOCK | FD_CLOEXEC);
   if (evfd < 0) {
@@ -90,15 +109,19 @@ EThread::EThread(ThreadType att, int anid)
 
 EThread::EThread(ThreadType att, Event * e, ink_sem * sem)
  : generator((uint32_t)((uintptr_t)time(NULL) ^ (uintptr_t) this)),
+   diskHandler(NULL),
    ethreads_to_be_signalled(NULL),
    n_ethreads_to_be_signalled(0),
    main_accept_index(-1),
-   id(NO_ETHREAD_ID), event_types(0),
-   signal_hook(0),
+   id(NO_ETHREAD_ID), event_types(0), cpu(-1),
+   signal_hook(0), ep(NULL),
+   idle(0), steal_count(0),
+   spin_max(0), spin_budget(0), spin_hook(0), wakeup_at(0), sleep_start(0),
    tt(att), oneevent(e), eventsem(sem)
 {
   ink_assert(att == DEDICATED);
   memset(thread_private, 0, PER_THREAD_DATA);
+  ink_zero(loop_stats);
 }
 
 
@@ -160,6 +183,65 @@ EThread::process_event(Event * e, int calling_code)
   }
 }
 
+// Take an immediate event from the sibling with the deepest stealable
+// queue, for the work stealing event types this thread belongs to.
+Event *
+EThread::steal_event()
+{
+  unsigned int types = event_types & eventProcessor.work_stealing_types;
+  EThread *victim = NULL;
+  int depth = 0;
+
+  for (int et = 0; types; et++, types >>= 1) {
+    if (!(types & 1))
+      continue;
+    for (int i = 0; i < eventProcessor.n_threads_for_type[et]; i++) {
+      EThread *t = eventProcessor.eventthread[et][i];
+      if (t != this && t->EventQueueExternal.steal_depth > depth) {
+        victim = t;
+        depth = t->EventQueueExternal.steal_depth;
+      }
+    }
+  }
+  if (!victim)
+    return NULL;
+  Event *e = victim->EventQueueExternal.steal();
+  if (e) {
+    e->ethread = this;
+    steal_count++;
+  }
+  return e;
+}
+
+// Spin until work shows up, the spin budget is used up or deadline
+// passes, whichever comes first.  Returns true if work showed up.
+bool
+EThread::spin_wait(ink_hrtime deadline)
+{
+  ink_hrtime start = ink_get_hrtime_internal(), now = start;
+  ink_hrtime left = deadline - ink_get_based_hrtime_internal();    // deadline is in based time
+  ink_hrtime end = start + (left < spin_budget ? left : spin_budget);
+  bool found = false;
+
+  while (now < end) {
+    if (!INK_ATOMICLIST_EMPTY(EventQueueExternal.al) || EventQueueExternal.steal_depth ||
+        (spin_hook && spin_hook(this))) {
+      found = true;
+      break;
+    }
+    now = ink_get_hrtime_internal();
+  }
+  loop_stats.spin_time += now - start;
+  if (found) {
+    loop_stats.spin_hits++;
+    spin_budget = spin_budget * 2 < spin_max ? spin_budget * 2 : spin_max;
+  } else {
+    loop_stats.spin_misses++;
+    spin_budget = spin_budget / 2 > spin_max / 16 ? spin_budget / 2 : spin_max / 16;
+  }
+  return found;
+}
+
 //
 // void  EThread::execute()
 //
@@ -180,6 +262,8 @@ EThread::execute() {
       Que(Event, link) NegativeQueue;
       ink_hrtime next_time = 0;
 
+      loop_stats.started = ink_get_hrtime_internal();
+
       // give priority to immediate events
       for (;;) {
         // execute all the available external events that have
@@ -204,6 +288,9 @@ EThread::execute() {
               NegativeQueue.insert(e, p);
           }
         }
+        // run the immediate events idle siblings have not stolen
+        while ((e = EventQueueExternal.dequeue_stealable()))
+          process_event(e, e->callback_event);
         bool done_one;
         do {
           done_one = false;
@@ -276,7 +363,18 @@ EThread::execute() {
           // cond_timedwait.
           if (n_ethreads_to_be_signalled)
             flush_signals(this);
+          // before sleeping, help out a busy sibling
+          if ((event_types & eventProcessor.work_stealing_types) && (e = steal_event())) {
+            process_event(e, e->callback_event);
+            continue;
+          }
+          if (spin_budget && spin_wait(next_time)) {
+            EventQueueExternal.dequeue_timed(cur_time, next_time, false);
+            continue;
+          }
+          sleep_begin();
           EventQueueExternal.dequeue_timed(cur_time, next_time, true);
+          sleep_end();
         }
       }
     }
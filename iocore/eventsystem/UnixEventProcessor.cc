@@ -23,6 +23,79 @@
 
 #include "P_EventSystem.h"      /* MAGIC_EDITING_TAG */
 
+// proxy.config.exec_thread.affinity: bind each event thread to one of
+// the machine's 1: NUMA nodes, 2: sockets, 3: cores, 4: processing
+// units, round robin by thread id.  0 leaves threads unbound.
+// Read once by EventProcessor::start(), before any thread is spawned.
+static int thread_affinity = 0;
+
+static void
+bind_ethread(EThread *t)
+{
+  if (thread_affinity <= 0)
+    return;
+#if TS_USE_HWLOC
+  hwloc_topology_t topology = ink_get_topology();
+  hwloc_obj_type_t obj_type;
+  const char *obj_name;
+
+  switch (thread_affinity) {
+  case 1:
+#if HWLOC_API_VERSION >= 0x00010b00
+    obj_type = HWLOC_OBJ_NUMANODE;
+#else
+    obj_type = HWLOC_OBJ_NODE;
+#endif
+    obj_name = "NUMA node";
+    break;
+  case 2:
+#if HWLOC_API_VERSION >= 0x00010b00
+    obj_type = HWLOC_OBJ_PACKAGE;
+#else
+    obj_type = HWLOC_OBJ_SOCKET;
+#endif
+    obj_name = "socket";
+    break;
+  case 3:
+    obj_type = HWLOC_OBJ_CORE;
+    obj_name = "core";
+    break;
+  default:
+    obj_type = HWLOC_OBJ_PU;
+    obj_name = "processing unit";
+    break;
+  }
+
+  int n = hwloc_get_nbobjs_by_type(topology, obj_type);
+  if (n <= 0)
+    return;
+  hwloc_obj_t obj = hwloc_get_obj_by_type(topology, obj_type, t->id % n);
+  if (hwloc_set_cpubind(topology, obj->cpuset, HWLOC_CPUBIND_THREAD | HWLOC_CPUBIND_STRICT) < 0) {
+    Warning("unable to bind event thread %d to %s %d: %s", t->id, obj_name, t->id % n, strerror(errno));
+    return;
+  }
+  // Memory is placed on the node of the thread which first touches it,
+  // so with the thread bound its buffers and freelist magazines are local.
+  if (obj_type == HWLOC_OBJ_CORE || obj_type == HWLOC_OBJ_PU)
+    t->cpu = hwloc_bitmap_first(obj->cpuset);
+  Debug("iocore_thread", "bound event thread %d to %s %d of %d (cpu %d)", t->id, obj_name, t->id % n, n, t->cpu);
+#else
+  NOWARN_UNUSED(t);
+#endif
+}
+
+// Event thread entry: the thread binds itself before it enters the
+// event loop, so nothing it allocates is touched from the wrong node.
+static void *
+bound_ethread_main(void *a)
+{
+  EThread *t = (EThread *) a;
+
+  bind_ethread(t);
+  t->execute();
+  return NULL;
+}
+
 
 
 EventType
@@ -48,7 +121,7 @@ EventProcessor::spawn_event_threads(int n_threads, const char* et_name)
   n_threads_for_type[new_thread_group_id] = n_threads;
   for (i = 0; i < n_threads; i++) {
     snprintf(thr_name, MAX_THREAD_NAME_LENGTH, "[%s %d]", et_name, i);
-    eventthread[new_thread_group_id][i]->start(thr_name);
+    eventthread[new_thread_group_id][i]->start(thr_name, bound_ethread_main, eventthread[new_thread_group_id][i]);
   }
 
   n_thread_groups++;
@@ -93,9 +166,25 @@ EventProcessor::start(int n_event_threads)
     t->set_event_type((EventType) ET_CALL);
   }
   n_threads_for_type[ET_CALL] = n_event_threads;
+
+  int spin_usec = 0;
+  REC_ReadConfigInteger(spin_usec, "proxy.config.exec_thread.spin_usec");
+  if (spin_usec > 0)
+    set_spin(ET_CALL, HRTIME_USECONDS(spin_usec));
+
+  REC_ReadConfigInteger(thread_affinity, "proxy.config.exec_thread.affinity");
+#if !TS_USE_HWLOC
+  if (thread_affinity > 0) {
+    Warning("proxy.config.exec_thread.affinity requires hwloc, event threads are not bound");
+    thread_affinity = 0;
+  }
+#endif
+
+  // The first thread is this one, which goes on to spawn every other
+  // thread; binding it would bind them all, so it is left unbound.
   for (i = first_thread; i < n_ethreads; i++) {
     snprintf(thr_name, MAX_THREAD_NAME_LENGTH, "[ET_NET %d]", i);
-    all_ethreads[i]->start(thr_name);
+    all_ethreads[i]->start(thr_name, bound_ethread_main, all_ethreads[i]);
   }
 
   Debug("iocore_thread", "Created event thread group id %d with %d threads", ET_CALL, n_event_threads);
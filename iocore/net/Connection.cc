@@ -150,6 +150,13 @@ Server::setup_fd_for_listen(
   if (http_accept_filter)
     add_http_filter(fd);
 
+#ifdef SO_REUSEPORT
+  // Best effort on an inherited socket, it lets the per thread listeners
+  // join its port. If this fails they fall back to sharing this fd.
+  if (reuse_port && safe_setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, SOCKOPT_ON, sizeof(int)) < 0)
+    Debug("iocore_net_accept", "unable to set SO_REUSEPORT on fd %d: %s", fd, strerror(errno));
+#endif
+
 #ifdef SEND_BUF_SIZE
   {
     int send_buf_size = SEND_BUF_SIZE;
@@ -338,6 +345,11 @@ Server::listen(bool non_blocking, int recv_bufsize, int send_bufsize, bool trans
   if ((res = safe_setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, SOCKOPT_ON, sizeof(int))) < 0)
     goto Lerror;
 
+#ifdef SO_REUSEPORT
+  if (reuse_port && (res = safe_setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, SOCKOPT_ON, sizeof(int))) < 0)
+    goto Lerror;
+#endif
+
   if ((res = socketManager.ink_bind(fd, &addr.sa, ink_inet_ip_size(&addr.sa), IPPROTO_TCP)) < 0) {
     goto Lerror;
   }
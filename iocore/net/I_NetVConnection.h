@@ -427,6 +427,31 @@ public:
   /** Set the TCP initial congestion window */
   virtual int set_tcp_init_cwnd(int init_cwnd) = 0;
 
+  /** Splice the data read from this connection straight into the
+      socket of @a target, without copying it through the read
+      IOBuffer.
+
+      Both connections must be plain sockets serviced by the calling
+      thread and the read and write VIOs must share a mutex. Data already
+      in the read buffer is still written by the consumer, the splice
+      path only kicks in once that buffer has drained. The pairing is
+      dropped on the next do_io_read() / do_io_write() or when either
+      side completes or closes.
+
+      @return false if splicing is not supported for this pair.
+  */
+  virtual bool set_splice_target(NetVConnection *target)
+  {
+    NOWARN_UNUSED(target);
+    return false;
+  }
+
+  /** @return true if this is a plain socket usable with set_splice_target(). */
+  virtual bool is_splice_capable()
+  {
+    return false;
+  }
+
   /** Set local sock addr struct. */
   virtual void set_local_addr() = 0;
 
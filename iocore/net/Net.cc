@@ -40,6 +40,7 @@ configure_net(void)
   IOCORE_RegisterConfigUpdateFunc("proxy.config.net.connections_throttle", change_net_connections_throttle, NULL);
   IOCORE_ReadConfigInteger(fds_throttle, "proxy.config.net.connections_throttle");
   IOCORE_ReadConfigInteger(throttle_enabled,"proxy.config.net.throttle_enabled");
+  IOCORE_ReadConfigInteger(net_config_write_cork, "proxy.config.net.write_cork");
 }
 
 
@@ -110,6 +111,33 @@ register_net_stats()
                      RECD_INT, RECP_NULL, (int) net_calls_to_write_nodata_stat, RecRawStatSyncSum);
   NET_CLEAR_DYN_STAT(net_calls_to_write_nodata_stat);
 
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.splice_bytes",
+                     RECD_INT, RECP_NULL, (int) net_splice_bytes_stat, RecRawStatSyncSum);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.corked_writes",
+                     RECD_INT, RECP_NULL, (int) net_corked_writes_stat, RecRawStatSyncSum);
+
+  // together with net_handler_run these give events and epoll_ctl()
+  // calls per NetHandler tick
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.poll_events",
+                     RECD_INT, RECP_NULL, (int) net_poll_events_stat, RecRawStatSyncSum);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.poll_ctl_calls",
+                     RECD_INT, RECP_NULL, (int) net_poll_ctl_calls_stat, RecRawStatSyncSum);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.ssl.ktls_send_connections",
+                     RECD_INT, RECP_NULL, (int) net_ssl_ktls_send_stat, RecRawStatSyncSum);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.timer_wheel.timers",
+                     RECD_INT, RECP_NON_PERSISTENT, (int) net_timers_stat, RecRawStatSyncSum);
+  NET_CLEAR_DYN_STAT(net_timers_stat);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.timer_wheel.timeouts",
+                     RECD_INT, RECP_NULL, (int) net_timeouts_stat, RecRawStatSyncSum);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.timer_wheel.expiry_lag",
+                     RECD_FLOAT, RECP_NULL, (int) net_timer_expiry_lag_stat, RecRawStatSyncHrTimeAvg);
+
 #ifndef INK_NO_SOCKS
   RecRegisterRawStat(net_rsb, RECT_PROCESS,
                      "proxy.process.socks.connections_successful",
@@ -211,6 +211,9 @@ struct Server: public Connection
   /// If set, a kernel HTTP accept filter
   bool http_accept_filter;
 
+  /// If set, listen with SO_REUSEPORT so several sockets can share the port.
+  bool reuse_port;
+
   //
   // Use this call for the main proxy accept
   //
@@ -235,6 +238,7 @@ struct Server: public Connection
   Server()
     : Connection()
     , f_outbound_transparent(false)
+    , reuse_port(false)
   {
     memset(&accept_addr, 0, sizeof(accept_addr));
   }
@@ -52,6 +52,14 @@ enum Net_Stats
   net_calls_to_writetonet_afterpoll_stat,
   net_calls_to_write_stat,
   net_calls_to_write_nodata_stat,
+  net_splice_bytes_stat,
+  net_corked_writes_stat,
+  net_poll_events_stat,
+  net_poll_ctl_calls_stat,
+  net_ssl_ktls_send_stat,
+  net_timers_stat,
+  net_timeouts_stat,
+  net_timer_expiry_lag_stat,
   socks_connections_successful_stat,
   socks_connections_unsuccessful_stat,
   socks_connections_currently_open_stat,
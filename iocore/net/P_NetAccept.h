@@ -60,10 +60,22 @@ class UnixNetVConnection;
 struct NetAcceptAction:public Action, public RefCountObj
 {
   Server *server;
+  Vec<int> thread_fds;          // SO_REUSEPORT listeners of the per thread copies
 
   void cancel(Continuation * cont = NULL) {
     Action::cancel(cont);
     server->close();
+    // close them now, so that the port is free, but keep their numbers
+    // on /dev/null until the copy on each thread sees the cancel and
+    // closes its own, so that no thread accepts on a reused fd
+    for (int i = 0; i < thread_fds.length(); i++) {
+      int null_fd = ::open("/dev/null", O_RDONLY);
+      if (null_fd >= 0) {
+        dup2(null_fd, thread_fds[i]);
+        ::close(null_fd);
+      } else
+        shutdown(thread_fds[i], SHUT_RDWR);
+    }
   }
 
   Continuation *operator =(Continuation * acont)
@@ -113,6 +125,7 @@ struct NetAccept:public Continuation
   virtual void init_accept_per_thread();
   // 0 == success
   int do_listen(bool non_blocking, bool transparent = false);
+  void set_listen_sockopts();
 
   int do_blocking_accept(EThread * t);
   virtual int acceptEvent(int event, void *e);
@@ -105,6 +105,17 @@ public:
   };
   int sslServerHandShakeEvent(int &err);
   int sslClientHandShakeEvent(int &err);
+  /// Only a kTLS socket can take spliced plaintext.
+  virtual bool is_splice_capable()
+  {
+    return ktls_send;
+  }
+  /// Our reads go through SSL_read(), so we never splice them out.
+  virtual bool set_splice_target(NetVConnection *target)
+  {
+    NOWARN_UNUSED(target);
+    return false;
+  }
   virtual void net_read_io(NetHandler * nh, EThread * lthread);
   virtual int64_t load_buffer_and_write(int64_t towrite, int64_t &wattempted, int64_t &total_wrote, MIOBufferAccessor & buf);
   virtual ~ SSLNetVConnection() { }
@@ -121,6 +132,9 @@ public:
 private:
   bool sslHandShakeComplete;
   bool sslClientConnection;
+  /// The kernel encrypts what we write, see ktls_setup().
+  bool ktls_send;
+  void ktls_setup();
   SSLNetVConnection(const SSLNetVConnection &);
   SSLNetVConnection & operator =(const SSLNetVConnection &);
 };
@@ -53,6 +53,14 @@
 #define EVENTIO_WRITE EPOLLOUT
 #endif
 #define EVENTIO_ERROR (EPOLLERR|EPOLLPRI|EPOLLHUP)
+#if defined(USE_EDGE_TRIGGER) && defined(EPOLLRDHUP)
+// lets a short read stand for a drained socket, see read_from_net()
+#define EVENTIO_PEER_CLOSED EPOLLRDHUP
+#endif
+#endif
+
+#ifndef EVENTIO_PEER_CLOSED
+#define EVENTIO_PEER_CLOSED 0
 #endif
 
 #if TS_USE_KQUEUE
@@ -170,6 +178,7 @@ extern ink_hrtime emergency_throttle_time;
 extern int net_connections_throttle;
 extern int fds_throttle;
 extern bool throttle_enabled;
+extern int net_config_write_cork;
 extern int fds_limit;
 extern ink_hrtime last_transient_accept_error;
 extern int http_accept_port_number;
@@ -219,6 +228,47 @@ struct PollCont:public Continuation
 };
 
 
+#ifndef INACTIVITY_TIMEOUT
+//
+// NetTimerWheel
+//
+// Hierarchical timing wheel holding the inactivity and active timeouts of
+// the connections on one NetHandler. The first level has one slot per tick
+// for the next 256 ticks, the two levels above cover 64 times the span of
+// the level below each and are cascaded down as time reaches them. Filing
+// and removing a connection is O(1).
+//
+// Entries are filed lazily: activity only pushes the deadline stored in the
+// connection out, and the entry is refiled at the new deadline when it comes
+// due. Only a deadline earlier than the filed one moves the entry.
+//
+#define NET_TIMER_TICK            HRTIME_SECONDS(1)
+#define NET_TIMER_L0_BITS         8
+#define NET_TIMER_LN_BITS         6
+#define NET_TIMER_LEVELS          3
+#define NET_TIMER_L0_SLOTS        (1 << NET_TIMER_L0_BITS)
+#define NET_TIMER_LN_SLOTS        (1 << NET_TIMER_LN_BITS)
+#define NET_TIMER_SLOTS           (NET_TIMER_L0_SLOTS + (NET_TIMER_LEVELS - 1) * NET_TIMER_LN_SLOTS)
+#define NET_TIMER_SPAN            ((int64_t)1 << (NET_TIMER_L0_BITS + (NET_TIMER_LEVELS - 1) * NET_TIMER_LN_BITS))
+
+struct NetTimerWheel
+{
+  DList(UnixNetVConnection, timer_link) slot[NET_TIMER_SLOTS];
+  int64_t cur;                  ///< last tick processed
+  int count;                    ///< connections on the wheel
+
+  void schedule(UnixNetVConnection *vc, ink_hrtime at);
+  void remove(UnixNetVConnection *vc);
+  void advance(ink_hrtime now, DList(UnixNetVConnection, cop_link) &expired);
+
+  NetTimerWheel();
+
+private:
+  void insert(UnixNetVConnection *vc, int64_t tick);
+  void cascade(int s);
+};
+#endif
+
 //
 // NetHandler
 //
@@ -235,6 +285,10 @@ public:
   DList(UnixNetVConnection, cop_link) cop_list;
   ASLLM(UnixNetVConnection, NetState, read, enable_link) read_enable_list;
   ASLLM(UnixNetVConnection, NetState, write, enable_link) write_enable_list;
+#ifndef INACTIVITY_TIMEOUT
+  NetTimerWheel timer_wheel;
+  ASLL(UnixNetVConnection, timer_refile_link) timer_refile_list;
+#endif
 
   time_t sec;
   int cycles;
@@ -481,6 +535,8 @@ TS_INLINE int EventIO::start(EventLoop l, NetAccept *vc, int events) {
 }
 TS_INLINE int EventIO::start(EventLoop l, UnixNetVConnection *vc, int events) {
   type = EVENTIO_READWRITE_VC;
+  if (events & EVENTIO_READ)
+    events |= EVENTIO_PEER_CLOSED;
   return start(l, vc->con.fd, (Continuation*)vc, events);
 }
 TS_INLINE int EventIO::start(EventLoop l, UnixUDPConnection *vc, int events) {
@@ -549,6 +605,7 @@ TS_INLINE int EventIO::start(EventLoop l, int afd, Continuation *c, int e) {
 #ifndef USE_EDGE_TRIGGER
   events = e;
 #endif
+  ink_atomic_increment(&event_loop->ctl_calls, 1);
   return epoll_ctl(event_loop->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
 #endif
 #if TS_USE_KQUEUE
@@ -581,6 +638,7 @@ TS_INLINE int EventIO::modify(int e) {
   events = new_events;
   ev.events = new_events;
   ev.data.ptr = this;
+  ink_atomic_increment(&event_loop->ctl_calls, 1);
   if (!new_events)
     return epoll_ctl(event_loop->epoll_fd, EPOLL_CTL_DEL, fd, &ev);
   else if (!old_events)
@@ -689,7 +747,11 @@ TS_INLINE int EventIO::stop() {
     struct epoll_event ev;
     memset(&ev, 0, sizeof(struct epoll_event));
     ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
-    return epoll_ctl(event_loop->epoll_fd, EPOLL_CTL_DEL, fd, &ev);
+    ink_atomic_increment(&event_loop->ctl_calls, 1);
+    int r = epoll_ctl(event_loop->epoll_fd, EPOLL_CTL_DEL, fd, &ev);
+    // a second stop(), e.g. from close(), needs no further syscall
+    event_loop = 0;
+    return r;
 #endif
 #if TS_USE_PORT
     int retval = port_dissociate(event_loop->port_fd, PORT_SOURCE_FD, fd);
@@ -173,6 +173,12 @@ public:
   }
   virtual void net_read_io(NetHandler *nh, EThread *lthread);
   virtual int64_t load_buffer_and_write(int64_t towrite, int64_t &wattempted, int64_t &total_wrote, MIOBufferAccessor & buf);
+  virtual bool set_splice_target(NetVConnection *target);
+  virtual bool is_splice_capable()
+  {
+    return (true);
+  }
+  void clear_splice();
   void readDisable(NetHandler *nh);
   void readSignalError(NetHandler *nh, int err);
   int readSignalDone(int event, NetHandler *nh);
@@ -198,6 +204,17 @@ public:
   Event *inactivity_timeout;
 #else
   ink_hrtime next_inactivity_timeout_at;
+  ink_hrtime next_active_timeout_at;
+
+  // NetHandler timer wheel entry, see NetTimerWheel
+  int timer_slot;               ///< wheel slot, -1 when not on the wheel
+  int64_t timer_tick;           ///< tick the entry is filed under
+  int timer_in_refile_list;
+  LINK(UnixNetVConnection, timer_link);
+  SLINK(UnixNetVConnection, timer_refile_link);
+
+  ink_hrtime next_timeout_at();
+  void timer_refile();
 #endif
   Event *active_timeout;
   EventIO ep;
@@ -215,6 +232,8 @@ public:
     {
       unsigned int got_local_addr:1;
       unsigned int shutdown:2;
+      unsigned int write_corked:1;
+      unsigned int peer_closed:1;
     } f;
   };
 
@@ -224,6 +243,11 @@ public:
   OOB_callback *oob_ptr;
   bool from_accept_thread;
 
+  // splice(2) fast path, see set_splice_target()
+  UnixNetVConnection *splice_to;        ///< consumer our reads are spliced into
+  UnixNetVConnection *splice_from;      ///< producer splicing into our writes
+  int splice_pipe[2];
+
   int startEvent(int event, Event *e);
   int acceptEvent(int event, Event *e);
   int mainEvent(int event, Event *e);
@@ -268,12 +292,25 @@ UnixNetVConnection::get_inactivity_timeout()
   return inactivity_timeout_in;
 }
 
+#ifndef INACTIVITY_TIMEOUT
+// Earliest armed inactivity or active timeout, 0 if there is none.
+TS_INLINE ink_hrtime
+UnixNetVConnection::next_timeout_at()
+{
+  ink_hrtime at = inactivity_timeout_in ? next_inactivity_timeout_at : 0;
+  if (active_timeout_in && next_active_timeout_at && (!at || next_active_timeout_at < at))
+    at = next_active_timeout_at;
+  return at;
+}
+#endif
+
 TS_INLINE void
 UnixNetVConnection::set_inactivity_timeout(ink_hrtime timeout)
 {
   inactivity_timeout_in = timeout;
 #ifndef INACTIVITY_TIMEOUT
   next_inactivity_timeout_at = ink_get_hrtime() + timeout;
+  timer_refile();
 #else
   if (inactivity_timeout)
     inactivity_timeout->cancel_action(this);
@@ -295,6 +332,14 @@ TS_INLINE void
 UnixNetVConnection::set_active_timeout(ink_hrtime timeout)
 {
   active_timeout_in = timeout;
+#ifndef INACTIVITY_TIMEOUT
+  // Like the event based version, only armed while I/O is enabled.
+  if (active_timeout_in && (read.enabled || write.enabled)) {
+    next_active_timeout_at = ink_get_hrtime() + active_timeout_in;
+    timer_refile();
+  } else
+    next_active_timeout_at = 0;
+#else
   if (active_timeout)
     active_timeout->cancel_action(this);
   if (active_timeout_in) {
@@ -308,6 +353,7 @@ UnixNetVConnection::set_active_timeout(ink_hrtime timeout)
       active_timeout = 0;
   } else
     active_timeout = 0;
+#endif
 }
 
 TS_INLINE void
@@ -327,6 +373,13 @@ UnixNetVConnection::cancel_inactivity_timeout()
 TS_INLINE void
 UnixNetVConnection::cancel_active_timeout()
 {
+#ifndef INACTIVITY_TIMEOUT
+  // The wheel entry is dropped lazily when it expires.
+  if (next_active_timeout_at) {
+    next_active_timeout_at = 0;
+    active_timeout_in = 0;
+  }
+#endif
   if (active_timeout) {
     active_timeout->cancel_action(this);
     active_timeout = NULL;
@@ -57,6 +57,7 @@ struct PollDescriptor
 #if TS_USE_EPOLL
   int epoll_fd;
   int nfds;                     // actual number
+  volatile int ctl_calls;       // epoll_ctl() calls since the last poll
   Pollfd pfd[POLL_DESCRIPTOR_SIZE];
   struct epoll_event ePoll_Triggered_Events[POLL_DESCRIPTOR_SIZE];
 #endif
@@ -136,6 +137,7 @@ struct PollDescriptor
 #endif
 #if TS_USE_EPOLL
     nfds = 0;
+    ctl_calls = 0;
     epoll_fd = epoll_create(POLL_DESCRIPTOR_SIZE);
     memset(ePoll_Triggered_Events, 0, sizeof(ePoll_Triggered_Events));
     memset(pfd, 0, sizeof(pfd));
@@ -186,6 +186,14 @@ SslConfigParams::initialize()
   if (!options)
     ssl_ctx_options |= SSL_OP_NO_COMPRESSION;
 #endif
+  IOCORE_ReadConfigInteger(options, "proxy.config.ssl.ktls");
+  if (options) {
+#ifdef SSL_OP_ENABLE_KTLS
+    ssl_ctx_options |= SSL_OP_ENABLE_KTLS;
+#else
+    Warning("proxy.config.ssl.ktls requires OpenSSL with kTLS support, ignored");
+#endif
+  }
 
   IOCORE_ReadConfigString(serverCertFilename, "proxy.config.ssl.server.cert.filename", PATH_NAME_MAX);
   IOCORE_ReadConfigString(serverCertRelativePath, "proxy.config.ssl.server.cert.path", PATH_NAME_MAX);
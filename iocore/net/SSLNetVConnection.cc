@@ -295,8 +295,27 @@ SSLNetVConnection::net_read_io(NetHandler * nh, EThread * lthread)
 }
 
 
+// With SSL_OP_ENABLE_KTLS (proxy.config.ssl.ktls) OpenSSL hands the
+// session keys to the kernel after the handshake if it can.  From then
+// on the kernel frames and encrypts whatever is written to the socket.
+void
+SSLNetVConnection::ktls_setup()
+{
+#ifdef BIO_get_ktls_send
+  ktls_send = BIO_get_ktls_send(SSL_get_wbio(ssl));
+  if (ktls_send) {
+    ProxyMutex *mutex = this_ethread()->mutex;
+    NET_INCREMENT_DYN_STAT(net_ssl_ktls_send_stat);
+  }
+#endif
+}
+
 int64_t
 SSLNetVConnection::load_buffer_and_write(int64_t towrite, int64_t &wattempted, int64_t &total_wrote, MIOBufferAccessor & buf) {
+  // plain writev() of the buffer, the kernel builds the records
+  if (ktls_send)
+    return UnixNetVConnection::load_buffer_and_write(towrite, wattempted, total_wrote, buf);
+
   ProxyMutex *mutex = this_ethread()->mutex;
   int64_t r = 0;
   int64_t l = 0;
@@ -397,7 +416,8 @@ SSLNetVConnection::SSLNetVConnection():
   write_want_write(0),
   write_want_read(0),
   write_want_ssl(0),
-  write_want_syscal(0), write_want_x509(0), write_error_zero(0), sslHandShakeComplete(false), sslClientConnection(false)
+  write_want_syscal(0), write_want_x509(0), write_error_zero(0), sslHandShakeComplete(false), sslClientConnection(false),
+  ktls_send(false)
 {
   ssl = NULL;
 }
@@ -450,6 +470,7 @@ SSLNetVConnection::free(EThread * t) {
   }
   sslHandShakeComplete = 0;
   sslClientConnection = 0;
+  ktls_send = false;
 
   if (from_accept_thread) {
     sslNetVCAllocator.free(this);  
@@ -524,6 +545,7 @@ SSLNetVConnection::sslServerHandShakeEvent(int &err)
       X509_free(client_cert);
     }
     sslHandShakeComplete = 1;
+    ktls_setup();
 
     return EVENT_DONE;
 
@@ -591,6 +613,7 @@ SSLNetVConnection::sslClientHandShakeEvent(int &err)
 
     X509_free(server_cert);
     sslHandShakeComplete = 1;
+    ktls_setup();
 
     return EVENT_DONE;
 
@@ -29,6 +29,7 @@ ink_hrtime emergency_throttle_time;
 int net_connections_throttle;
 int fds_throttle;
 bool throttle_enabled;
+int net_config_write_cork = 0;
 int fds_limit = 8000;
 ink_hrtime last_transient_accept_error;
 
@@ -36,9 +37,106 @@ extern "C" void fd_reify(struct ev_loop *);
 
 
 #ifndef INACTIVITY_TIMEOUT
+NetTimerWheel::NetTimerWheel()
+  : cur(ink_get_hrtime() / NET_TIMER_TICK), count(0)
+{ }
+
+void
+NetTimerWheel::insert(UnixNetVConnection *vc, int64_t tick)
+{
+  int64_t delta = tick - cur;
+  int s;
+
+  if (delta >= NET_TIMER_SPAN) {
+    // Past the top level, parked at its far end and refiled from there.
+    tick = cur + NET_TIMER_SPAN - 1;
+    delta = NET_TIMER_SPAN - 1;
+  }
+  if (delta < NET_TIMER_L0_SLOTS) {
+    s = (int)(tick & (NET_TIMER_L0_SLOTS - 1));
+  } else {
+    int level = 1, shift = NET_TIMER_L0_BITS;
+    while (delta >= ((int64_t)1 << (shift + NET_TIMER_LN_BITS))) {
+      level++;
+      shift += NET_TIMER_LN_BITS;
+    }
+    s = NET_TIMER_L0_SLOTS + (level - 1) * NET_TIMER_LN_SLOTS + (int)((tick >> shift) & (NET_TIMER_LN_SLOTS - 1));
+  }
+  vc->timer_slot = s;
+  vc->timer_tick = tick;
+  slot[s].push(vc);
+}
+
+void
+NetTimerWheel::schedule(UnixNetVConnection *vc, ink_hrtime at)
+{
+  int64_t tick = (at + NET_TIMER_TICK - 1) / NET_TIMER_TICK;
+
+  // The current tick has been processed already.
+  if (tick <= cur)
+    tick = cur + 1;
+  if (vc->timer_slot >= 0) {
+    if (vc->timer_tick <= tick)
+      return;
+    slot[vc->timer_slot].remove(vc);
+  } else {
+    count++;
+    RecIncrRawStatSum(net_rsb, this_ethread(), (int) net_timers_stat, 1);
+  }
+  insert(vc, tick);
+}
+
+void
+NetTimerWheel::remove(UnixNetVConnection *vc)
+{
+  if (vc->timer_slot < 0)
+    return;
+  slot[vc->timer_slot].remove(vc);
+  vc->timer_slot = -1;
+  count--;
+  RecIncrRawStatSum(net_rsb, this_ethread(), (int) net_timers_stat, -1);
+}
+
+// Refile the entries of a higher level slot, they all land below it. The
+// ones due right now go to the level 0 slot that is expired next.
+void
+NetTimerWheel::cascade(int s)
+{
+  DList(UnixNetVConnection, timer_link) l = slot[s];
+
+  slot[s].clear();
+  while (UnixNetVConnection *vc = l.pop())
+    insert(vc, vc->timer_tick);
+}
+
+//
+// Move everything that is due by now onto expired.
+//
+void
+NetTimerWheel::advance(ink_hrtime now, DList(UnixNetVConnection, cop_link) &expired)
+{
+  int64_t target = now / NET_TIMER_TICK;
+
+  while (cur < target) {
+    cur++;
+    int shift = NET_TIMER_L0_BITS;
+    for (int level = 1; level < NET_TIMER_LEVELS && !(cur & (((int64_t)1 << shift) - 1)); level++) {
+      cascade(NET_TIMER_L0_SLOTS + (level - 1) * NET_TIMER_LN_SLOTS + (int)((cur >> shift) & (NET_TIMER_LN_SLOTS - 1)));
+      shift += NET_TIMER_LN_BITS;
+    }
+    DList(UnixNetVConnection, timer_link) &l = slot[cur & (NET_TIMER_L0_SLOTS - 1)];
+    while (UnixNetVConnection *vc = l.pop()) {
+      vc->timer_slot = -1;
+      count--;
+      RecIncrRawStatSum(net_rsb, this_ethread(), (int) net_timers_stat, -1);
+      expired.push(vc);
+    }
+  }
+}
+
 // INKqa10496
-// One Inactivity cop runs on each thread once every second and
-// loops through the list of NetVCs and calls the timeouts
+// One Inactivity cop runs on each thread once every second, advances the
+// NetHandler timer wheel and calls the timeouts of the NetVCs that are due.
 struct InactivityCop : public Continuation {
   InactivityCop(ProxyMutex *m):Continuation(m) {
     SET_HANDLER(&InactivityCop::check_inactivity);
@@ -47,17 +145,41 @@ struct InactivityCop : public Continuation {
     (void) event;
     ink_hrtime now = ink_get_hrtime();
     NetHandler *nh = get_NetHandler(this_ethread());
-    // Copy the list and use pop() to catch any closes caused by callbacks.
-    forl_LL(UnixNetVConnection, vc, nh->open_list)
-      nh->cop_list.push(vc);
-    while (UnixNetVConnection *vc = nh->cop_list.pop()) {
-      MUTEX_LOCK(lock, vc->mutex, this_ethread());
+    UnixNetVConnection *vc;
+
+    // Timeouts set from other threads.
+    SList(UnixNetVConnection, timer_refile_link) rq(nh->timer_refile_list.popall());
+    while ((vc = rq.pop())) {
+      vc->timer_in_refile_list = 0;
+      vc->timer_refile();
+    }
+
+    // Collect on the cop_list so that closes caused by callbacks are caught.
+    nh->timer_wheel.advance(now, nh->cop_list);
+    while ((vc = nh->cop_list.pop())) {
+      MUTEX_TRY_LOCK(lock, vc->mutex, this_ethread());
+      if (!lock) {
+        // Busy on another thread, look again next tick.
+        nh->timer_wheel.schedule(vc, now + NET_TIMER_TICK);
+        continue;
+      }
       if (vc->closed) {
         close_UnixNetVConnection(vc, e->ethread);
         continue;
-      } 
-      if (vc->next_inactivity_timeout_at && vc->next_inactivity_timeout_at < now)
-        vc->handleEvent(EVENT_IMMEDIATE, e);
+      }
+      ink_hrtime at = vc->next_timeout_at();
+      if (!at)
+        continue;
+      if (at > now) {
+        // Activity moved the deadline since this entry was filed.
+        nh->timer_wheel.schedule(vc, at);
+        continue;
+      }
+      RecIncrRawStatSum(net_rsb, this_ethread(), (int) net_timeouts_stat, 1);
+      RecIncrRawStat(net_rsb, this_ethread(), (int) net_timer_expiry_lag_stat, now - at);
+      // Look again next tick unless the handler clears or resets the timeout.
+      nh->timer_wheel.schedule(vc, now + NET_TIMER_TICK);
+      vc->handleEvent(EVENT_IMMEDIATE, e);
     }
     return 0;
   }
@@ -183,6 +305,24 @@ net_signal_hook_function(EThread *thread) {
 #endif
 }
 
+#if TS_USE_EPOLL
+// Busy poll while the thread spins before sleeping; the events are
+// left in the PollDescriptor for mainNetEvent. VCs reenabled from other
+// threads raise no poll event, so stop spinning for those as well.
+static int
+net_spin_hook_function(EThread *thread)
+{
+  NetHandler *nh = get_NetHandler(thread);
+  PollDescriptor *pd = get_PollDescriptor(thread);
+  if (!nh->read_enable_list.empty() || !nh->write_enable_list.empty()) {
+    pd->result = 0;
+    return 1;
+  }
+  pd->result = epoll_wait(pd->epoll_fd, pd->ePoll_Triggered_Events, POLL_DESCRIPTOR_SIZE, 0);
+  return pd->result > 0;
+}
+#endif
+
 void
 initialize_thread_for_net(EThread *thread, int thread_index)
 {
@@ -207,6 +347,9 @@ initialize_thread_for_net(EThread *thread, int thread_index)
 #endif
 
   thread->signal_hook = net_signal_hook_function;
+#if TS_USE_EPOLL
+  thread->spin_hook = net_spin_hook_function;
+#endif
   thread->ep = (EventIO*)ats_malloc(sizeof(EventIO));
   thread->ep->type = EVENTIO_ASYNC_SIGNAL;
 #if TS_HAS_EVENTFD
@@ -288,8 +431,26 @@ NetHandler::mainNetEvent(int event, Event *e)
   else
     poll_timeout = net_config_poll_timeout;
 
+  // Events scheduled and VCs enabled from other threads wake us through
+  // the eventfd in the poll set, but only while we are marked idle.
+  EThread *t = trigger_event->ethread;
   PollDescriptor *pd = get_PollDescriptor(trigger_event->ethread);
   UnixNetVConnection *vc = NULL;
+  bool polled = false, slept = false;
+#if TS_USE_EPOLL
+  // spinning polls, so if it found sockets ready there is no need to poll again
+  if (poll_timeout && t->spin_budget && t->spin_wait(t->cur_time + HRTIME_MSECONDS(poll_timeout))) {
+    poll_timeout = 0;
+    polled = pd->result > 0;
+  }
+#endif
+  if (poll_timeout) {
+    t->sleep_begin();
+    slept = true;
+    if (!INK_ATOMICLIST_EMPTY(t->EventQueueExternal.al) || !read_enable_list.empty() || !write_enable_list.empty())
+      poll_timeout = 0;
+  }
+
 #if TS_USE_LIBEV
   struct ev_loop *eio = pd->eio;
   double pt = (double)poll_timeout/1000.0;
@@ -298,7 +459,8 @@ NetHandler::mainNetEvent(int event, Event *e)
   pd->result = eio->pendingcnt[0];
   NetDebug("iocore_net_main_poll", "[NetHandler::mainNetEvent] backend_poll(%d,%f), result=%d", eio->backend_fd,pt,pd->result);
 #elif TS_USE_EPOLL
-  pd->result = epoll_wait(pd->epoll_fd, pd->ePoll_Triggered_Events, POLL_DESCRIPTOR_SIZE, poll_timeout);
+  if (!polled)
+    pd->result = epoll_wait(pd->epoll_fd, pd->ePoll_Triggered_Events, POLL_DESCRIPTOR_SIZE, poll_timeout);
   NetDebug("iocore_net_main_poll", "[NetHandler::mainNetEvent] epoll_wait(%d,%d), result=%d", pd->epoll_fd,poll_timeout,pd->result);
 #elif TS_USE_KQUEUE
   struct timespec tv;
@@ -336,6 +498,13 @@ NetHandler::mainNetEvent(int event, Event *e)
 
 #else
 #error port me
+#endif
+  if (slept)
+    t->sleep_end();
+  NET_SUM_DYN_STAT(net_poll_events_stat, pd->result);
+#if TS_USE_EPOLL
+  if (pd->ctl_calls)
+    NET_SUM_DYN_STAT(net_poll_ctl_calls_stat, ink_atomic_swap(&pd->ctl_calls, 0));
 #endif
 
   vc = NULL;
@@ -343,7 +512,9 @@ NetHandler::mainNetEvent(int event, Event *e)
     epd = (EventIO*) get_ev_data(pd,x);
     if (epd->type == EVENTIO_READWRITE_VC) {
       vc = epd->data.vc;
-      if (get_ev_events(pd,x) & (EVENTIO_READ|EVENTIO_ERROR)) {
+      if (get_ev_events(pd,x) & EVENTIO_PEER_CLOSED)
+        vc->f.peer_closed = 1;
+      if (get_ev_events(pd,x) & (EVENTIO_READ|EVENTIO_PEER_CLOSED|EVENTIO_ERROR)) {
         vc->read.triggered = 1;
         if (!read_ready_list.in(vc))
           read_ready_list.enqueue(vc);
@@ -437,3 +608,47 @@ NetHandler::mainNetEvent(int event, Event *e)
   return EVENT_CONT;
 }
 
+
+#if defined(TS_HAS_TESTS) && !defined(INACTIVITY_TIMEOUT)
+REGRESSION_TEST(net_timer_wheel) (RegressionTest *t, int atype, int *pstatus) {
+  NOWARN_UNUSED(atype);
+  // deadlines in ticks, covering every level and the clamp past the top one
+  static const int64_t deadline[] = { 1, 3, 255, 256, 300, 16383, 16384, 20000, 1000000, NET_TIMER_SPAN + 5 };
+  const int n = sizeof(deadline) / sizeof(deadline[0]);
+  NetTimerWheel *w = NEW(new NetTimerWheel);
+  UnixNetVConnection *vc = NEW(new UnixNetVConnection[n]);
+  DList(UnixNetVConnection, cop_link) expired;
+  ink_hrtime base = w->cur * NET_TIMER_TICK;
+  int ok = 1;
+
+  *pstatus = REGRESSION_TEST_INPROGRESS;
+  for (int i = 0; i < n; i++)
+    w->schedule(&vc[i], base + deadline[i] * NET_TIMER_TICK);
+  // moving to a later deadline is lazy, an earlier one moves the entry
+  w->schedule(&vc[0], base + 100 * NET_TIMER_TICK);
+  w->schedule(&vc[1], base + 2 * NET_TIMER_TICK);
+  if (w->count != n)
+    ok = 0;
+
+  for (int i = 0; i < n && ok; i++) {
+    int64_t due = i == 1 ? 2 : (deadline[i] < NET_TIMER_SPAN ? deadline[i] : NET_TIMER_SPAN - 1);
+    w->advance(base + (due - 1) * NET_TIMER_TICK, expired);
+    if (expired.in(&vc[i]) || vc[i].timer_slot < 0) {
+      rprintf(t, "timer %d expired before tick %" PRId64 "\n", i, due);
+      ok = 0;
+    }
+    w->advance(base + due * NET_TIMER_TICK, expired);
+    if (vc[i].timer_slot >= 0) {
+      rprintf(t, "timer %d not expired at tick %" PRId64 "\n", i, due);
+      ok = 0;
+    }
+    while (expired.pop())
+      ;
+  }
+  if (w->count)
+    ok = 0;
+  delete[] vc;
+  delete w;
+  *pstatus = ok ? REGRESSION_TEST_PASSED : REGRESSION_TEST_FAILED;
+}
+#endif
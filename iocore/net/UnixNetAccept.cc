@@ -212,10 +212,20 @@ NetAccept::init_accept(EThread * t)
 }
 
 
+//
+// With server.reuse_port set every ET_NET thread but the last gets its own
+// SO_REUSEPORT listener on the same address, so the kernel spreads new
+// connections across the threads instead of waking all of them on one fd.
+// The last thread keeps the original socket. Once a copy cannot listen
+// the rest share it. In the usual deployment the original is inherited
+// from traffic_manager, which sets SO_REUSEPORT on it for us, but the
+// copies still only bind if traffic_server runs as the user that created
+// it and may bind the port (not a privileged one without the capability).
+//
 void
 NetAccept::init_accept_per_thread()
 {
-  int i, n;
+  int i, n, res;
 
   if (do_listen(NON_BLOCKING))
     return;
@@ -226,14 +236,39 @@ NetAccept::init_accept_per_thread()
   period = ACCEPT_PERIOD;
 
   NetAccept *a;
+  bool reuse_port = server.reuse_port;
   n = eventProcessor.n_threads_for_type[ET_NET];
   for (i = 0; i < n; i++) {
     if (i < n - 1) {
       a = NEW(new NetAccept);
       *a = *this;
+      if (reuse_port) {
+        a->server.fd = NO_FD;
+        ink_inet_copy(&a->server.accept_addr, &server.addr);
+        if ((res = a->server.listen(NON_BLOCKING, recv_bufsize, send_bufsize))) {
+          Warning("unable to open SO_REUSEPORT listener for port %d: %s, "
+                  "net threads %d to %d share the accept socket",
+                  ink_inet_get_port(&server.addr), strerror(-res), i, n - 1);
+          a->server.fd = server.fd;
+          reuse_port = false;
+        } else {
+          a->set_listen_sockopts();
+          action_->thread_fds.add(a->server.fd);
+          Debug("iocore_net_accept", "thread %d listening on port %d with fd %d", i,
+                ink_inet_get_port(&server.addr), a->server.fd);
+        }
+      }
     } else
       a = this;
     EThread *t = eventProcessor.eventthread[ET_NET][i];
+#ifdef SO_INCOMING_CPU
+    // Steer connections whose packets arrive on the NIC queue serviced by
+    // this thread's processor to this thread's own listener.
+    if (server.reuse_port && t->cpu >= 0 && (a == this || a->server.fd != server.fd)) {
+      if (safe_setsockopt(a->server.fd, SOL_SOCKET, SO_INCOMING_CPU, (char *) &t->cpu, sizeof(int)) < 0)
+        Debug("iocore_net_accept", "unable to set SO_INCOMING_CPU %d on fd %d: %s", t->cpu, a->server.fd, strerror(errno));
+    }
+#endif
     PollDescriptor *pd = get_PollDescriptor(t);
     if (a->ep.start(pd, a, EVENTIO_READ) < 0)
       Warning("[NetAccept::init_accept_per_thread]:error starting EventIO");
@@ -269,6 +304,36 @@ NetAccept::do_listen(bool non_blocking, bool transparent)
 }
 
 
+//
+// Socket options that are set on the listening socket once it is open.
+//
+void
+NetAccept::set_listen_sockopts()
+{
+  if (server.fd == NO_FD)
+    return;
+#ifdef TCP_DEFER_ACCEPT
+  // set tcp defer accept timeout if it is configured, this will not trigger an accept until there is
+  // data on the socket ready to be read
+  int should_filter_int = 0;
+  IOCORE_ReadConfigInteger(should_filter_int, "proxy.config.net.defer_accept");
+  if (should_filter_int > 0) {
+    setsockopt(server.fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &should_filter_int, sizeof(int));
+  }
+#endif
+#ifdef TCP_INIT_CWND
+ int tcp_init_cwnd = 0;
+ IOCORE_ReadConfigInteger(tcp_init_cwnd, "proxy.config.http.server_tcp_init_cwnd");
+ if(tcp_init_cwnd > 0) {
+    Debug("net", "Setting initial congestion window to %d", tcp_init_cwnd);
+    if(setsockopt(server.fd, IPPROTO_TCP, TCP_INIT_CWND, &tcp_init_cwnd, sizeof(int)) != 0) {
+      Error("Cannot set initial congestion window to %d", tcp_init_cwnd);
+    }
+ }
+#endif
+}
+
+
 int
 NetAccept::do_blocking_accept(EThread * t)
 {
@@ -396,6 +461,20 @@ NetAccept::acceptFastEvent(int event, void *ep)
   UnixNetVConnection *vc = NULL;
   int loop = accept_till_done;
 
+  if (action_->cancelled) {
+    // the cancel closed the listeners, the per thread copies still hold
+    // their fd numbers
+    if (action_->thread_fds.in(server.fd)) {
+      this->ep.stop();
+      server.close();
+    }
+    e->cancel();
+    if (action_->server == &server)
+      NET_DECREMENT_DYN_STAT(net_accepts_currently_open_stat);
+    delete this;
+    return EVENT_DONE;
+  }
+
   do {
     if (check_net_throttle(ACCEPT, ink_get_hrtime())) {
       ifd = -1;
@@ -555,6 +634,7 @@ NetAccept::NetAccept()
 void
 NetAccept::cancel()
 {
+  // also closes the per thread listeners
   action_->cancel();
   server.close();
 }
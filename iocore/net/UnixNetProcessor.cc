@@ -141,6 +141,11 @@ UnixNetProcessor::accept_internal(
   if (should_filter_int > 0 && opt.etype == ET_NET)
     na->server.http_accept_filter = true;
 
+  // Per thread accepts can give every ET_NET thread its own listener.
+  int reuse_port = 0;
+  IOCORE_ReadConfigInteger(reuse_port, "proxy.config.net.accept_reuseport");
+  na->server.reuse_port = (reuse_port > 0 && opt.frequent_accept && accept_threads <= 0);
+
   na->action_ = NEW(new NetAcceptAction());
   *na->action_ = cont;
   na->action_->server = &na->server;
@@ -172,23 +177,7 @@ UnixNetProcessor::accept_internal(
   } else
     na->init_accept();
 
-#ifdef TCP_DEFER_ACCEPT
-  // set tcp defer accept timeout if it is configured, this will not trigger an accept until there is
-  // data on the socket ready to be read
-  if (should_filter_int > 0) {
-    setsockopt(na->server.fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &should_filter_int, sizeof(int));
-  }
-#endif
-#ifdef TCP_INIT_CWND
- int tcp_init_cwnd = 0;
- IOCORE_ReadConfigInteger(tcp_init_cwnd, "proxy.config.http.server_tcp_init_cwnd");
- if(tcp_init_cwnd > 0) {
-    Debug("net", "Setting initial congestion window to %d", tcp_init_cwnd);
-    if(setsockopt(na->server.fd, IPPROTO_TCP, TCP_INIT_CWND, &tcp_init_cwnd, sizeof(int)) != 0) {
-      Error("Cannot set initial congestion window to %d", tcp_init_cwnd);
-    }
- }
-#endif
+  na->set_listen_sockopts();
   return na->action_;
 }
 
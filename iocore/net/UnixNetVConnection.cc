@@ -55,6 +55,25 @@ read_reschedule(NetHandler *nh, UnixNetVConnection *vc)
     nh->read_ready_list.remove(vc);
 }
 
+// Hold back partial segments while a write VIO of known length waits
+// for more data, so that e.g. a response header leaves together with
+// the first body bytes.  Uncorking pushes whatever is queued, and Linux
+// flushes a corked socket by itself after 200ms.
+static inline void
+write_cork(UnixNetVConnection *vc, bool cork)
+{
+#if defined(TCP_CORK)
+  int on = 1, off = 0;
+  if (vc->f.write_corked == (unsigned int) cork)
+    return;
+  safe_setsockopt(vc->con.fd, IPPROTO_TCP, TCP_CORK, cork ? SOCKOPT_ON : SOCKOPT_OFF, sizeof(int));
+  vc->f.write_corked = cork;
+#else
+  NOWARN_UNUSED(vc);
+  NOWARN_UNUSED(cork);
+#endif
+}
+
 static inline void
 write_reschedule(NetHandler *nh, UnixNetVConnection *vc)
 {
@@ -81,9 +100,11 @@ net_activity(UnixNetVConnection *vc, EThread *thread)
       vc->inactivity_timeout = 0;
   }
 #else
-  if (vc->inactivity_timeout_in)
+  if (vc->inactivity_timeout_in) {
     vc->next_inactivity_timeout_at = ink_get_hrtime() + vc->inactivity_timeout_in;
-  else
+    if (vc->timer_slot < 0)
+      vc->timer_refile();
+  } else
     vc->next_inactivity_timeout_at = 0;
 #endif
 
@@ -97,6 +118,7 @@ close_UnixNetVConnection(UnixNetVConnection *vc, EThread *t)
 {
   NetHandler *nh = vc->nh;
   vc->cancel_OOB();
+  vc->clear_splice();
   vc->ep.stop();
   vc->con.close();
 #ifdef INACTIVITY_TIMEOUT
@@ -106,6 +128,12 @@ close_UnixNetVConnection(UnixNetVConnection *vc, EThread *t)
   }
 #else
   vc->next_inactivity_timeout_at = 0;
+  vc->next_active_timeout_at = 0;
+  nh->timer_wheel.remove(vc);
+  if (vc->timer_in_refile_list) {
+    nh->timer_refile_list.remove(vc);
+    vc->timer_in_refile_list = 0;
+  }
 #endif
   vc->inactivity_timeout_in = 0;
   if (vc->active_timeout) {
@@ -165,6 +193,7 @@ static inline int
 read_signal_done(int event, NetHandler *nh, UnixNetVConnection *vc)
 {
   vc->read.enabled = 0;
+  vc->clear_splice();
   if (read_signal_and_update(event, vc) == EVENT_DONE) {
     return EVENT_DONE;
   } else {
@@ -199,6 +228,83 @@ write_signal_error(NetHandler *nh, UnixNetVConnection *vc, int lerrno)
   return write_signal_done(VC_EVENT_ERROR, nh, vc);
 }
 
+#if TS_HAS_SPLICE
+// Check whether the next read on vc can be spliced straight into the
+// consumer's socket. Data still sitting in the read buffer must be written
+// by the consumer first to keep the byte order, and the consumer's VIO has
+// to be driven by the same mutex we are holding, on this thread, as we
+// signal it from here.
+static inline bool
+splice_ready(UnixNetVConnection *vc, int64_t &toread, MIOBufferAccessor & buf)
+{
+  UnixNetVConnection *dst = vc->splice_to;
+
+  if (!dst || buf.mbuf->max_read_avail())
+    return false;
+  if (dst->closed || (dst->f.shutdown & NET_VC_SHUTDOWN_WRITE) || dst->write.vio.op != VIO::WRITE ||
+      dst->write.vio.mutex.m_ptr != vc->read.vio.mutex.m_ptr || dst->thread != vc->thread)
+    return false;
+  int64_t dtodo = dst->write.vio.ntodo();
+  if (dtodo <= 0)
+    return false;
+  if (toread > dtodo)
+    toread = dtodo;
+  if (vc->splice_pipe[0] < 0 && pipe2(vc->splice_pipe, O_NONBLOCK | O_CLOEXEC) < 0) {
+    Debug("iocore_net", "unable to create splice pipe, errno %d", errno);
+    vc->splice_pipe[0] = vc->splice_pipe[1] = -1;
+    vc->clear_splice();
+    return false;
+  }
+  return true;
+}
+
+// Move up to toread bytes from the socket of vc through the pipe into the
+// socket of its consumer. Whatever the consumer could not take right away is
+// read back out of the pipe into the free space of the read buffer (toread
+// never exceeds it), so the normal write path delivers it. Returns what a
+// plain read would have returned, spliced is the part that skipped the buffer.
+static int64_t
+splice_from_net(UnixNetVConnection *vc, int64_t toread, MIOBufferAccessor & buf, int64_t &spliced)
+{
+  int64_t r, n;
+
+  spliced = 0;
+  do {
+    r = splice(vc->con.fd, NULL, vc->splice_pipe[1], NULL, toread, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  } while (r < 0 && errno == EINTR);
+  if (r <= 0)
+    return r < 0 ? -errno : 0;
+
+  while (spliced < r) {
+    n = splice(vc->splice_pipe[0], NULL, vc->splice_to->con.fd, NULL, r - spliced,
+               SPLICE_F_MOVE | SPLICE_F_NONBLOCK | SPLICE_F_MORE);
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR)
+        continue;
+      break;
+    }
+    spliced += n;
+  }
+
+  // Pull the remainder back into the buffer, leaving the pipe empty.
+  int64_t left = r - spliced;
+  IOBufferBlock *b = buf.mbuf->_writer;
+  while (left > 0 && b) {
+    int64_t a = b->write_avail();
+    if (a > 0) {
+      if (a > left)
+        a = left;
+      n = socketManager.read(vc->splice_pipe[0], b->_end, a);
+      ink_release_assert(n == a);
+      left -= n;
+    }
+    b = b->next;
+  }
+  ink_release_assert(left == 0);
+  return r;
+}
+#endif
+
 // Read the data for a UnixNetVConnection.
 // Rescheduling the UnixNetVConnection by moving the VC
 // onto or off of the ready_list.
@@ -240,6 +346,13 @@ read_from_net(NetHandler *nh, UnixNetVConnection *vc, EThread *thread)
   int niov = 0;
   IOVec tiovec[NET_MAX_IOV];
   if (toread) {
+#if TS_HAS_SPLICE
+    int64_t spliced = 0;
+    if (splice_ready(vc, toread, buf)) {
+      r = splice_from_net(vc, toread, buf, spliced);
+      NET_DEBUG_COUNT_DYN_STAT(net_calls_to_read_stat, 1);
+    } else {
+#endif
     IOBufferBlock *b = buf.mbuf->_writer;
     do {
       niov = 0;
@@ -268,6 +381,14 @@ read_from_net(NetHandler *nh, UnixNetVConnection *vc, EThread *thread)
       total_read += rattempted;
     } while (r == rattempted && total_read < toread);
 
+#if TS_USE_EPOLL && defined(USE_EDGE_TRIGGER)
+    // A short read emptied the socket and any later data raises a new
+    // edge, so skip the read which would only return EAGAIN.  A FIN
+    // raises no further edge, so keep reading once the peer closed.
+    if (r > 0 && r < rattempted && EVENTIO_PEER_CLOSED && !vc->f.peer_closed)
+      vc->read.triggered = 0;
+#endif
+
     // if we have already moved some bytes successfully, summarize in r
     if (total_read != rattempted) {
       if (r <= 0)
@@ -275,6 +396,9 @@ read_from_net(NetHandler *nh, UnixNetVConnection *vc, EThread *thread)
       else
         r = total_read - rattempted + r;
     }
+#if TS_HAS_SPLICE
+    }
+#endif
     // check for errors
     if (r <= 0) {
 
@@ -297,14 +421,62 @@ read_from_net(NetHandler *nh, UnixNetVConnection *vc, EThread *thread)
     }
     NET_SUM_DYN_STAT(net_read_bytes_stat, r);
 
+#if TS_HAS_SPLICE
+    // Add the rest to the buffer and signal continuation.
+    buf.writer()->fill(r - spliced);
+#else
     // Add data to buffer and signal continuation.
     buf.writer()->fill(r);
+#endif
 #ifdef DEBUG
     if (buf.writer()->write_avail() <= 0)
       Debug("iocore_net", "read_from_net, read buffer full");
 #endif
     s->vio.ndone += r;
     net_activity(vc, thread);
+#if TS_HAS_SPLICE
+    // The spliced bytes are already on the consumer's socket, account
+    // for them on its write VIO and signal both sides here.  The producer
+    // goes first, since a tunnel expects to see bytes read before they
+    // are written, and either handler may close either VC, so both are
+    // held open until the two callbacks are done.
+    if (spliced) {
+      UnixNetVConnection *dst = vc->splice_to;
+      bool read_done = s->vio.ntodo() <= 0;
+      NET_SUM_DYN_STAT(net_write_bytes_stat, spliced);
+      NET_SUM_DYN_STAT(net_splice_bytes_stat, spliced);
+      dst->write.vio.ndone += spliced;
+      net_activity(dst, thread);
+      vc->recursion++;
+      dst->recursion++;
+      if (read_done)
+        read_signal_done(VC_EVENT_READ_COMPLETE, nh, vc);
+      else
+        read_signal_and_update(VC_EVENT_READ_READY, vc);
+      if (!dst->closed && dst->write.vio._cont) {
+        if (dst->write.vio.ntodo() <= 0) {
+          write_cork(dst, false);
+          write_signal_done(VC_EVENT_WRITE_COMPLETE, dst->nh, dst);
+        } else
+          write_signal_and_update(VC_EVENT_WRITE_READY, dst);
+      }
+      if (!--dst->recursion && dst->closed)
+        close_UnixNetVConnection(dst, thread);
+      if (!--vc->recursion && vc->closed) {
+        close_UnixNetVConnection(vc, thread);
+        return;
+      }
+      if (read_done)
+        return;
+      // change of lock... don't look at shared variables!
+      if (lock.m.m_ptr != s->vio.mutex.m_ptr || s->vio.op != VIO::READ) {
+        read_reschedule(nh, vc);
+        return;
+      }
+      // The producer has already been signalled.
+      r = 0;
+    }
+#endif
   } else
     r = 0;
 
@@ -437,6 +609,11 @@ write_to_net_io(NetHandler *nh, UnixNetVConnection *vc, EThread *thread)
     return;
   }
 
+  if (net_config_write_cork && towrite < ntodo && s->vio.nbytes != INT64_MAX && !vc->f.write_corked) {
+    write_cork(vc, true);
+    NET_INCREMENT_DYN_STAT(net_corked_writes_stat);
+  }
+
   int64_t total_wrote = 0, wattempted = 0;
   int64_t r = vc->load_buffer_and_write(towrite, wattempted, total_wrote, buf);
 
@@ -476,6 +653,7 @@ write_to_net_io(NetHandler *nh, UnixNetVConnection *vc, EThread *thread)
     // If there are no more bytes to write, signal write complete,
     ink_assert(ntodo >= 0);
     if (s->vio.ntodo() <= 0) {
+      write_cork(vc, false);
       write_signal_done(VC_EVENT_WRITE_COMPLETE, nh, vc);
       return;
     } else if (!signalled) {
@@ -503,6 +681,7 @@ VIO *
 UnixNetVConnection::do_io_read(Continuation *c, int64_t nbytes, MIOBuffer *buf)
 {
   ink_assert(!closed);
+  clear_splice();
   read.vio.op = VIO::READ;
   read.vio.mutex = c->mutex;
   read.vio._cont = c;
@@ -524,6 +703,9 @@ VIO *
 UnixNetVConnection::do_io_write(Continuation *c, int64_t nbytes, IOBufferReader *reader, bool owner)
 {
   ink_assert(!closed);
+  clear_splice();
+  // whatever a previous write left corked goes out now
+  write_cork(this, false);
   write.vio.op = VIO::WRITE;
   write.vio.mutex = c->mutex;
   write.vio._cont = c;
@@ -577,6 +759,10 @@ UnixNetVConnection::do_io_close(int alerrno /* = -1 */ )
   if (!recursion) {
     close_UnixNetVConnection(this, t);
   }
+#ifndef INACTIVITY_TIMEOUT
+  else
+    timer_refile();
+#endif
 }
 
 void
@@ -612,6 +798,68 @@ UnixNetVConnection::do_io_shutdown(ShutdownHowTo_t howto)
   }
 }
 
+#ifndef INACTIVITY_TIMEOUT
+//
+// File this connection on its NetHandler's timer wheel at its earliest
+// pending timeout. The wheel belongs to the NetHandler thread, calls from
+// other threads go through timer_refile_list which the InactivityCop drains.
+//
+void
+UnixNetVConnection::timer_refile()
+{
+  if (!nh)
+    return;
+  if (thread != this_ethread()) {
+    if (!timer_in_refile_list) {
+      timer_in_refile_list = 1;
+      nh->timer_refile_list.push(this);
+    }
+    return;
+  }
+  ink_hrtime at = closed ? ink_get_hrtime() : next_timeout_at();
+  if (at)
+    nh->timer_wheel.schedule(this, at);
+}
+#endif
+
+bool
+UnixNetVConnection::set_splice_target(NetVConnection *target)
+{
+#if TS_HAS_SPLICE
+  UnixNetVConnection *dst = (UnixNetVConnection *) target;
+
+  if (!target || target == this || !target->is_splice_capable() || closed || dst->closed)
+    return false;
+  // Both ends are driven from read_from_net() on this thread.
+  if (thread != this_ethread() || dst->thread != thread)
+    return false;
+  clear_splice();
+  dst->clear_splice();
+  splice_to = dst;
+  dst->splice_from = this;
+  return true;
+#else
+  NOWARN_UNUSED(target);
+  return false;
+#endif
+}
+
+void
+UnixNetVConnection::clear_splice()
+{
+  if (splice_from)
+    splice_from->clear_splice();
+  if (splice_to) {
+    splice_to->splice_from = NULL;
+    splice_to = NULL;
+  }
+  if (splice_pipe[0] >= 0) {
+    socketManager.close(splice_pipe[0]);
+    socketManager.close(splice_pipe[1]);
+    splice_pipe[0] = splice_pipe[1] = -1;
+  }
+}
+
 int
 OOB_callback::retry_OOB_send(int event, Event *e)
 {
@@ -716,8 +964,8 @@ UnixNetVConnection::reenable(VIO *vio)
           nh->write_enable_list.push(this);
         }
       }
-	  if (nh->trigger_event && nh->trigger_event->ethread->signal_hook)
-		nh->trigger_event->ethread->signal_hook(nh->trigger_event->ethread);
+      if (nh->trigger_event && nh->trigger_event->ethread->signal_hook)
+        nh->trigger_event->ethread->wakeup();
     } else {
       if (vio == &read.vio) {
         ep.modify(EVENTIO_READ);
@@ -772,12 +1020,14 @@ UnixNetVConnection::UnixNetVConnection()
 #ifdef INACTIVITY_TIMEOUT
     inactivity_timeout(NULL),
 #else
-    next_inactivity_timeout_at(0),
+    next_inactivity_timeout_at(0), next_active_timeout_at(0),
+    timer_slot(-1), timer_tick(0), timer_in_refile_list(0),
 #endif
     active_timeout(NULL), nh(NULL),
     id(0), accept_port(0), flags(0), recursion(0), submit_time(0), oob_ptr(0),
-    from_accept_thread(false)
+    from_accept_thread(false), splice_to(NULL), splice_from(NULL)
 {
+  splice_pipe[0] = splice_pipe[1] = -1;
   memset(&local_addr, 0, sizeof local_addr);
   memset(&server_addr, 0, sizeof server_addr);
   SET_HANDLER((NetVConnHandler) & UnixNetVConnection::startEvent);
@@ -795,8 +1045,10 @@ UnixNetVConnection::set_enabled(VIO *vio)
   if (!inactivity_timeout && inactivity_timeout_in)
     inactivity_timeout = vio->mutex->thread_holding->schedule_in_local(this, inactivity_timeout_in);
 #else
-  if (!next_inactivity_timeout_at && inactivity_timeout_in)
+  if (!next_inactivity_timeout_at && inactivity_timeout_in) {
     next_inactivity_timeout_at = ink_get_hrtime() + inactivity_timeout_in;
+    timer_refile();
+  }
 #endif
 }
 
@@ -845,6 +1097,16 @@ UnixNetVConnection::load_buffer_and_write(int64_t towrite, int64_t &wattempted,
       b = b->next;
     }
     wattempted = total_wrote - total_wrote_last;
+#if defined(MSG_MORE)
+    if (net_config_write_cork && total_wrote < towrite) {
+      // another batch follows right away, don't push a short segment
+      struct msghdr msg;
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_iov = &tiovec[0];
+      msg.msg_iovlen = niov;
+      r = socketManager.sendmsg(con.fd, &msg, MSG_MORE);
+    } else
+#endif
     if (niov == 1)
       r = socketManager.write(con.fd, tiovec[0].iov_base, tiovec[0].iov_len);
     else
@@ -853,6 +1115,12 @@ UnixNetVConnection::load_buffer_and_write(int64_t towrite, int64_t &wattempted,
     NET_DEBUG_COUNT_DYN_STAT(net_calls_to_write_stat, 1);
   } while (r == wattempted && total_wrote < towrite);
 
+#if TS_USE_EPOLL && defined(USE_EDGE_TRIGGER)
+  // the socket buffer is full, wait for EPOLLOUT instead of an EAGAIN
+  if (r > 0 && r < wattempted)
+    write.triggered = 0;
+#endif
+
   return (r);
 }
 
@@ -1016,10 +1284,16 @@ UnixNetVConnection::mainEvent(int event, Event *e)
     /* BZ 49408 */
     //ink_debug_assert(inactivity_timeout_in);
     //ink_debug_assert(next_inactivity_timeout_at < ink_get_hrtime());
-    if (!inactivity_timeout_in || next_inactivity_timeout_at > ink_get_hrtime())
-      return EVENT_CONT;
-    signal_event = VC_EVENT_INACTIVITY_TIMEOUT;
-    signal_timeout_at = &next_inactivity_timeout_at;
+    ink_hrtime now = ink_get_hrtime();
+    if (active_timeout_in && next_active_timeout_at && next_active_timeout_at <= now) {
+      signal_event = VC_EVENT_ACTIVE_TIMEOUT;
+      signal_timeout_at = &next_active_timeout_at;
+    } else {
+      if (!inactivity_timeout_in || next_inactivity_timeout_at > now)
+        return EVENT_CONT;
+      signal_event = VC_EVENT_INACTIVITY_TIMEOUT;
+      signal_timeout_at = &next_inactivity_timeout_at;
+    }
   }
 #endif
   else {
@@ -1148,6 +1422,10 @@ UnixNetVConnection::free(EThread *t)
   ink_debug_assert(!link.next && !link.prev);
   ink_debug_assert(!active_timeout);
   ink_debug_assert(con.fd == NO_FD);
+  ink_debug_assert(!splice_to && !splice_from && splice_pipe[0] < 0);
+#ifndef INACTIVITY_TIMEOUT
+  ink_debug_assert(timer_slot < 0 && !timer_in_refile_list);
+#endif
   ink_debug_assert(t == this_ethread());
 
   if (from_accept_thread) {
@@ -1156,3 +1434,193 @@ UnixNetVConnection::free(EThread *t)
     THREAD_FREE(this, netVCAllocator, t);
   }
 }
+
+#if defined(TS_HAS_TESTS) && TS_HAS_SPLICE
+// Splice a body of known length from one loopback connection into another
+// and check that the consumer's write VIO is driven to WRITE_COMPLETE, after
+// the producer's READ_COMPLETE for the same bytes.
+struct SpliceTest: public Continuation
+{
+  RegressionTest *t;
+  int *pstatus;
+  int lfd[2];                   // listeners the two VCs connect to
+  int peer[2];                  // test ends, feeding the source and draining the sink
+  UnixNetVConnection *vc[2];
+  int nvc;
+  MIOBuffer *buf;
+  VIO *read_vio;
+  VIO *write_vio;
+  Event *tick;
+  int64_t fed, drained, spliced_before;
+  int ok, read_complete, write_complete;
+  ink_hrtime deadline;
+
+  static const int64_t body_len = 1 << 20;
+
+  static char pattern(int64_t i)
+  {
+    return (char) (i % 251);
+  }
+
+  int listen_on_loopback(sockaddr_in *addr)
+  {
+    socklen_t len = sizeof(*addr);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || bind(fd, (sockaddr *) addr, sizeof(*addr)) < 0 || listen(fd, 1) < 0 ||
+        getsockname(fd, (sockaddr *) addr, &len) < 0) {
+      if (fd >= 0)
+        close(fd);
+      return -1;
+    }
+    return fd;
+  }
+
+  int startEvent(int event, Event *e)
+  {
+    NOWARN_UNUSED(event);
+    NOWARN_UNUSED(e);
+    sockaddr_in addr;
+    if ((lfd[nvc] = listen_on_loopback(&addr)) < 0) {
+      rprintf(t, "unable to listen on loopback, errno %d\n", errno);
+      return done(false);
+    }
+    SET_HANDLER(&SpliceTest::openEvent);
+    netProcessor.connect_re(this, (sockaddr *) &addr);
+    return EVENT_DONE;
+  }
+
+  int openEvent(int event, void *data)
+  {
+    if (event != NET_EVENT_OPEN) {
+      rprintf(t, "connect failed, event %d\n", event);
+      return done(false);
+    }
+    vc[nvc] = (UnixNetVConnection *) data;
+    if ((peer[nvc] = accept(lfd[nvc], NULL, NULL)) < 0 || fcntl(peer[nvc], F_SETFL, O_NONBLOCK) < 0) {
+      rprintf(t, "accept failed, errno %d\n", errno);
+      return done(false);
+    }
+    if (++nvc < 2)
+      return startEvent(EVENT_IMMEDIATE, NULL);
+
+    NET_READ_DYN_SUM(net_splice_bytes_stat, spliced_before);
+    buf = new_MIOBuffer(BUFFER_SIZE_INDEX_32K);
+    SET_HANDLER(&SpliceTest::mainEvent);
+    read_vio = vc[0]->do_io_read(this, body_len, buf);
+    write_vio = vc[1]->do_io_write(this, body_len, buf->alloc_reader());
+    if (!vc[0]->set_splice_target(vc[1])) {
+      rprintf(t, "set_splice_target refused a loopback pair\n");
+      return done(false);
+    }
+    deadline = ink_get_hrtime() + HRTIME_SECONDS(10);
+    tick = this_ethread()->schedule_every_local(this, HRTIME_MSECONDS(5));
+    return EVENT_CONT;
+  }
+
+  int mainEvent(int event, void *data)
+  {
+    NOWARN_UNUSED(data);
+    switch (event) {
+    case VC_EVENT_READ_COMPLETE:
+      read_complete = 1;
+      // fall through
+    case VC_EVENT_READ_READY:
+      write_vio->reenable();
+      return EVENT_CONT;
+    case VC_EVENT_WRITE_READY:
+      read_vio->reenable();
+      return EVENT_CONT;
+    case VC_EVENT_WRITE_COMPLETE:
+      write_complete = 1;
+      if (!read_complete) {
+        rprintf(t, "write complete signalled before read complete\n");
+        ok = 0;
+      }
+      if (write_vio->ndone != body_len) {
+        rprintf(t, "write complete after %" PRId64 " bytes\n", write_vio->ndone);
+        ok = 0;
+      }
+      return EVENT_CONT;
+    case EVENT_INTERVAL:
+      break;
+    default:
+      rprintf(t, "unexpected event %d\n", event);
+      ok = 0;
+      return EVENT_CONT;
+    }
+
+    char b[32 * 1024];
+    while (fed < body_len) {
+      int64_t n = body_len - fed < (int64_t) sizeof(b) ? body_len - fed : (int64_t) sizeof(b);
+      for (int64_t i = 0; i < n; i++)
+        b[i] = pattern(fed + i);
+      n = write(peer[0], b, n);
+      if (n <= 0)
+        break;
+      fed += n;
+    }
+    int64_t n;
+    while ((n = read(peer[1], b, sizeof(b))) > 0) {
+      for (int64_t i = 0; i < n; i++)
+        if (b[i] != pattern(drained + i))
+          ok = 0;
+      drained += n;
+    }
+    if (drained >= body_len && write_complete)
+      return done(ok && drained == body_len);
+    if (ink_get_hrtime() > deadline) {
+      rprintf(t, "timed out, fed %" PRId64 " drained %" PRId64 " write complete %d\n", fed, drained, write_complete);
+      return done(false);
+    }
+    return EVENT_CONT;
+  }
+
+  int done(bool passed)
+  {
+    int64_t spliced;
+    NET_READ_DYN_SUM(net_splice_bytes_stat, spliced);
+    if (passed && spliced == spliced_before) {
+      rprintf(t, "body was not spliced\n");
+      passed = false;
+    }
+    if (tick)
+      tick->cancel();
+    for (int i = 0; i < 2; i++) {
+      if (vc[i]) {
+        // closing outside of the NetHandler needs its lock
+        MUTEX_LOCK(lock, vc[i]->nh->mutex, this_ethread());
+        vc[i]->do_io_close();
+      }
+      if (peer[i] >= 0)
+        close(peer[i]);
+      if (lfd[i] >= 0)
+        close(lfd[i]);
+    }
+    if (buf)
+      free_MIOBuffer(buf);
+    *pstatus = passed ? REGRESSION_TEST_PASSED : REGRESSION_TEST_FAILED;
+    delete this;
+    return EVENT_DONE;
+  }
+
+  SpliceTest(RegressionTest *at, int *apstatus)
+    : Continuation(new_ProxyMutex()), t(at), pstatus(apstatus), nvc(0), buf(NULL), read_vio(NULL), write_vio(NULL),
+      tick(NULL), fed(0), drained(0), spliced_before(0), ok(1), read_complete(0), write_complete(0),
+      deadline(0)
+  {
+    lfd[0] = lfd[1] = peer[0] = peer[1] = -1;
+    vc[0] = vc[1] = NULL;
+    SET_HANDLER(&SpliceTest::startEvent);
+  }
+};
+
+REGRESSION_TEST(net_splice) (RegressionTest *t, int atype, int *pstatus) {
+  NOWARN_UNUSED(atype);
+  *pstatus = REGRESSION_TEST_INPROGRESS;
+  // both VCs must land on the same net thread, so connect from one
+  eventProcessor.schedule_imm(NEW(new SpliceTest(t, pstatus)), ET_NET);
+}
+#endif
@@ -88,9 +88,11 @@ public:
 
   /** Re-initialize the parameters of the allocator. */
   void
-  re_init(const char *name, unsigned int element_size, unsigned int chunk_size, unsigned int alignment)
+  re_init(const char *name, unsigned int element_size, unsigned int chunk_size, unsigned int alignment,
+          bool use_hugepages = false)
   {
     ink_freelist_init(&this->fl, name, element_size, chunk_size, 0, alignment);
+    this->fl.use_hugepages = use_hugepages;
   }
 
 protected:
@@ -60,6 +60,13 @@ setup_hwloc()
 
   hwloc_setup = true;
 }
+
+hwloc_topology_t
+ink_get_topology()
+{
+  setup_hwloc();
+  return gTopology;
+}
 #endif
 
 int
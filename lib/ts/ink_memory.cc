@@ -31,6 +31,7 @@
 #endif
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 
 void *
 ats_malloc(size_t size)
@@ -182,3 +183,97 @@ ats_mallopt(int param, int value)
 #endif // ! TS_HAS_JEMALLOC
   return 0;
 }
+
+#define HUGEPAGE_DEFAULT_SIZE (2 * 1024 * 1024)
+#define HUGEPAGE_GIGANTIC_SIZE (1024 * 1024 * 1024)
+
+static int hugepage_mode = 0;
+static size_t hugepage_size = 0;
+
+volatile int64_t ats_hugepage_hugetlb_bytes = 0;
+volatile int64_t ats_hugepage_thp_bytes = 0;
+volatile int64_t ats_hugepage_fallbacks = 0;
+
+void
+ats_hugepage_init(int mode)
+{
+  hugepage_mode = mode;
+  hugepage_size = 0;
+  if (!mode)
+    return;
+  hugepage_size = HUGEPAGE_DEFAULT_SIZE;
+#if defined(linux)
+  FILE *fp = fopen("/proc/meminfo", "r");
+  if (fp) {
+    char line[256];
+    long kb;
+    while (fgets(line, sizeof(line), fp)) {
+      if (sscanf(line, "Hugepagesize: %ld kB", &kb) == 1) {
+        if (kb > 0)
+          hugepage_size = (size_t) kb * 1024;
+        break;
+      }
+    }
+    fclose(fp);
+  }
+#endif
+}
+
+int
+ats_hugepage_enabled(void)
+{
+  return hugepage_mode != 0;
+}
+
+size_t
+ats_hugepage_size(void)
+{
+  return hugepage_size;
+}
+
+// Try explicit huge pages first, then an aligned anonymous mapping with
+// MADV_HUGEPAGE so that khugepaged can back it with transparent huge pages.
+void *
+ats_alloc_hugepage(size_t size)
+{
+  if (!hugepage_mode || !size)
+    return NULL;
+#if defined(MAP_HUGETLB)
+  void *ptr;
+  size_t len;
+#if defined(MAP_HUGE_SHIFT)
+  if (hugepage_mode > 1 && size >= HUGEPAGE_GIGANTIC_SIZE) {
+    len = (size + HUGEPAGE_GIGANTIC_SIZE - 1) & ~((size_t) HUGEPAGE_GIGANTIC_SIZE - 1);
+    ptr = mmap(NULL, len, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (30 << MAP_HUGE_SHIFT), -1, 0);
+    if (ptr != MAP_FAILED) {
+      ink_atomic_increment64(&ats_hugepage_hugetlb_bytes, (int64_t) len);
+      return ptr;
+    }
+  }
+#endif
+  len = (size + hugepage_size - 1) / hugepage_size * hugepage_size;
+  ptr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (ptr != MAP_FAILED) {
+    ink_atomic_increment64(&ats_hugepage_hugetlb_bytes, (int64_t) len);
+    return ptr;
+  }
+#if defined(MADV_HUGEPAGE)
+  // over-map by one huge page and trim to get an aligned region
+  size_t map_len = len + hugepage_size;
+  char *base = (char *) mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base != (char *) MAP_FAILED) {
+    char *aligned = (char *) (((uintptr_t) base + hugepage_size - 1) & ~((uintptr_t) hugepage_size - 1));
+    if (aligned > base)
+      munmap(base, aligned - base);
+    if (base + map_len > aligned + len)
+      munmap(aligned + len, (base + map_len) - (aligned + len));
+    madvise(aligned, len, MADV_HUGEPAGE);
+    ink_atomic_increment64(&ats_hugepage_thp_bytes, (int64_t) len);
+    return aligned;
+  }
+#endif
+#endif
+  ink_atomic_increment64(&ats_hugepage_fallbacks, 1);
+  return NULL;
+}
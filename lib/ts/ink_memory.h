@@ -52,6 +52,20 @@ extern "C"
   void ats_memalign_free(void *ptr);
   int ats_mallopt(int param, int value);
 
+  /* Huge page backed arenas. ats_hugepage_init() selects the mode:
+     0 disabled, 1 default huge pages (falling back to transparent huge
+     pages), 2 additionally tries 1GB pages for allocations of at least
+     1GB. ats_alloc_hugepage() returns NULL when disabled; memory it
+     returns is never released. */
+  void ats_hugepage_init(int mode);
+  int ats_hugepage_enabled(void);
+  size_t ats_hugepage_size(void);
+  void *ats_alloc_hugepage(size_t size);
+
+  extern volatile int64_t ats_hugepage_hugetlb_bytes;
+  extern volatile int64_t ats_hugepage_thp_bytes;
+  extern volatile int64_t ats_hugepage_fallbacks;
+
 #define ats_strdup(p)        _xstrdup((p), -1, NULL)
 #define ats_strndup(p,n)     _xstrdup((p), n, NULL)
 
@@ -48,6 +48,8 @@
 #include "ink_error.h"
 #include "ink_assert.h"
 #include "ink_resource.h"
+#include "ink_thread.h"
+#include "ink_unused.h"
 
 
 #ifdef __x86_64__
@@ -102,6 +104,8 @@ inkcoreapi volatile int64_t freelist_allocated_mem = 0;
 //}
 
 
+static void magazine_init(InkFreeList * f);
+
 void
 ink_freelist_init(InkFreeList * f,
                   const char *name, uint32_t type_size, uint32_t chunk_size, uint32_t offset, uint32_t alignment)
@@ -109,11 +113,17 @@ ink_freelist_init(InkFreeList * f,
   ink_freelist_list *fll;
 
   /* its safe to add to this global list because ink_freelist_init()
-     is only called from single-threaded initialization code. */
-  fll = (ink_freelist_list *)ats_malloc(sizeof(ink_freelist_list));
-  fll->fl = f;
-  fll->next = freelists;
-  freelists = fll;
+     is only called from single-threaded initialization code.
+     Allocator::re_init() calls it again on the same freelist. */
+  for (fll = freelists; fll; fll = fll->next)
+    if (fll->fl == f)
+      break;
+  if (!fll) {
+    fll = (ink_freelist_list *)ats_malloc(sizeof(ink_freelist_list));
+    fll->fl = f;
+    fll->next = freelists;
+    freelists = fll;
+  }
 
   f->name = name;
   f->offset = offset;
@@ -128,6 +138,8 @@ ink_freelist_init(InkFreeList * f,
   f->allocated = 0;
   f->allocated_base = 0;
   f->count_base = 0;
+  f->use_hugepages = 0;
+  magazine_init(f);
 }
 
 InkFreeList *
@@ -147,10 +159,288 @@ int fake_global_for_ink_queue = 0;
 
 int fastmemtotal = 0;
 
+/*
+ * Per thread magazines.
+ *
+ * The freelist head is a cache line every thread CASes on each
+ * allocation and free.  To avoid that, each thread keeps two
+ * magazines (chains of free items, linked through the item's next
+ * pointer) per freelist and allocates from and frees to them without
+ * atomics.  A thread with both magazines full hands one to the
+ * freelist's depot, and a thread with both empty takes one back: one
+ * CAS per magazine_size items.  Depot entries are linked through the
+ * word after the next pointer.  Only when the depot is empty do we go
+ * to the freelist itself, and if that is empty too the new chunk
+ * refills the calling thread's magazine, so the memory is first
+ * touched on that thread's NUMA node.
+ *
+ * Items held in magazines and the depot are counted as in use.
+ */
+#define MAGAZINE_MAX_FREELISTS  512
+#define MAGAZINE_MAX_ITEMS      64
+#define MAGAZINE_MAX_BYTES      (64 * 1024)
+
+#define MAGAZINE_NEXT(_x) (*(void **)(_x))
+#define DEPOT_NEXT(_x) (((void * volatile *)(_x))[1])
+
+typedef struct
+{
+  void *head;
+  uint32_t count;
+} InkMagazine;
+
+typedef struct
+{
+  InkMagazine loaded, previous;
+  uint64_t hits, misses;
+} InkMagazineSlot;
+
+typedef struct _ink_magazine_cache
+{
+  InkMagazineSlot slot[MAGAZINE_MAX_FREELISTS];
+  struct _ink_magazine_cache *next, *prev;
+} InkMagazineCache;
+
+#if TS_USE_FREELIST
+static void *freelist_new(InkFreeList * f, InkMagazine * keep);
+static void freelist_free(InkFreeList * f, void *item);
+#endif
+
+static InkFreeList *magazine_freelists[MAGAZINE_MAX_FREELISTS];
+static volatile int magazine_freelists_used = 0;
+static bool magazine_setup = false;
+static ink_thread_key magazine_key;
+static InkMagazineCache *magazine_caches = NULL;
+static ink_mutex magazine_caches_mutex;
+
+// Return every cached item to its freelist when the thread exits.
+static void
+magazine_cache_destroy(void *value)
+{
+#if TS_USE_FREELIST
+  InkMagazineCache *c = (InkMagazineCache *) value;
+
+  ink_mutex_acquire(&magazine_caches_mutex);
+  if (c->prev)
+    c->prev->next = c->next;
+  else
+    magazine_caches = c->next;
+  if (c->next)
+    c->next->prev = c->prev;
+  ink_mutex_release(&magazine_caches_mutex);
+
+  for (int i = 0; i < magazine_freelists_used; i++) {
+    InkFreeList *f = magazine_freelists[i];
+    InkMagazineSlot *s = &c->slot[i];
+    InkMagazine *m[2] = { &s->loaded, &s->previous };
+
+    for (int j = 0; j < 2; j++) {
+      void *item;
+      while ((item = m[j]->head)) {
+        m[j]->head = MAGAZINE_NEXT(item);
+        MAGAZINE_NEXT(item) = NULL;
+        freelist_free(f, item);
+      }
+    }
+    if (s->hits)
+      ink_atomic_increment64(&f->magazine_hits, (int64_t) s->hits);
+    if (s->misses)
+      ink_atomic_increment64(&f->magazine_misses, (int64_t) s->misses);
+  }
+  ats_free(c);
+#else
+  (void) value;
+#endif
+}
+
+static void
+magazine_init(InkFreeList * f)
+{
+  uint32_t n = f->type_size ? MAGAZINE_MAX_BYTES / f->type_size : 0;
+
+  SET_FREELIST_POINTER_VERSION(f->depot, FROM_PTR(0), 0);
+  f->magazine_hits = 0;
+  f->magazine_misses = 0;
+  f->magazine_size = 0;
+  f->magazine_index = 0;
+#if TS_USE_FREELIST
+  /* ink_freelist_init() is only called from single-threaded initialization code. */
+  if (!magazine_setup) {
+    ink_thread_key_create(&magazine_key, magazine_cache_destroy);
+    ink_mutex_init(&magazine_caches_mutex, "magazine_caches");
+    magazine_setup = true;
+  }
+  // Items must hold both links, and big items would pin too much memory.
+  if (f->offset || f->type_size < 2 * sizeof(void *) || n < 2)
+    return;
+  // a freelist initialized again keeps its slot
+  int i;
+  for (i = 0; i < magazine_freelists_used; i++)
+    if (magazine_freelists[i] == f)
+      break;
+  if (i == magazine_freelists_used) {
+    if (magazine_freelists_used >= MAGAZINE_MAX_FREELISTS)
+      return;
+    magazine_freelists[magazine_freelists_used++] = f;
+  }
+  f->magazine_size = n < MAGAZINE_MAX_ITEMS ? n : MAGAZINE_MAX_ITEMS;
+  f->magazine_index = i;
+#else
+  (void) n;
+#endif
+}
+
+static inline InkMagazineSlot *
+magazine_slot(InkFreeList * f)
+{
+  InkMagazineCache *c = (InkMagazineCache *) ink_thread_getspecific(magazine_key);
+
+  if (unlikely(!c)) {
+    c = (InkMagazineCache *) ats_calloc(1, sizeof(InkMagazineCache));
+    ink_mutex_acquire(&magazine_caches_mutex);
+    c->next = magazine_caches;
+    if (c->next)
+      c->next->prev = c;
+    magazine_caches = c;
+    ink_mutex_release(&magazine_caches_mutex);
+    ink_thread_setspecific(magazine_key, c);
+  }
+  return &c->slot[f->magazine_index];
+}
+
+static void
+magazine_depot_push(InkFreeList * f, void *chain)
+{
+  head_p h;
+  head_p item_pair;
+
+  do {
+    INK_QUEUE_LD64(h, f->depot);
+    DEPOT_NEXT(chain) = FREELIST_POINTER(h);
+    SET_FREELIST_POINTER_VERSION(item_pair, FROM_PTR(chain), FREELIST_VERSION(h));
+    INK_MEMORY_BARRIER;
+  } while (!ink_atomic_cas64((int64_t *) & f->depot.data, h.data, item_pair.data));
+}
+
+static void *
+magazine_depot_pop(InkFreeList * f)
+{
+  head_p item;
+  head_p next;
+
+  do {
+    INK_QUEUE_LD64(item, f->depot);
+    if (TO_PTR(FREELIST_POINTER(item)) == NULL)
+      return NULL;
+    SET_FREELIST_POINTER_VERSION(next, DEPOT_NEXT(TO_PTR(FREELIST_POINTER(item))), FREELIST_VERSION(item) + 1);
+  } while (!ink_atomic_cas64((int64_t *) & f->depot.data, item.data, next.data));
+  return TO_PTR(FREELIST_POINTER(item));
+}
+
+void
+ink_freelists_dump_magazines(FILE * f)
+{
+  ink_freelist_list *fll;
+  if (f == NULL)
+    f = stderr;
+
+  fprintf(f, "    magazine hits   |  magazine misses   | size | type size  |   free list name\n");
+  fprintf(f, "--------------------|--------------------|------|------------|----------------------------------\n");
+
+  for (fll = freelists; fll; fll = fll->next) {
+    InkFreeList *fl = fll->fl;
+    if (!fl->magazine_size)
+      continue;
+    uint64_t hits = fl->magazine_hits, misses = fl->magazine_misses;
+    ink_mutex_acquire(&magazine_caches_mutex);
+    for (InkMagazineCache *c = magazine_caches; c; c = c->next) {
+      hits += c->slot[fl->magazine_index].hits;
+      misses += c->slot[fl->magazine_index].misses;
+    }
+    ink_mutex_release(&magazine_caches_mutex);
+    fprintf(f, " %18" PRIu64 " | %18" PRIu64 " | %4u | %10u | memory/%s\n",
+            hits, misses, fl->magazine_size, fl->type_size, fl->name ? fl->name : "<unknown>");
+  }
+}
+
 void *
 ink_freelist_new(InkFreeList * f)
 {
 #if TS_USE_FREELIST
+  if (f->magazine_size) {
+    InkMagazineSlot *s = magazine_slot(f);
+
+    if (!s->loaded.count) {
+      if (s->previous.count) {
+        InkMagazine t = s->loaded;
+        s->loaded = s->previous;
+        s->previous = t;
+      } else if ((s->loaded.head = magazine_depot_pop(f))) {
+        s->loaded.count = f->magazine_size;
+      }
+    }
+    if (s->loaded.count) {
+      void *item = s->loaded.head;
+      s->loaded.head = MAGAZINE_NEXT(item);
+      s->loaded.count--;
+      s->hits++;
+      return item;
+    }
+    s->misses++;
+    return freelist_new(f, &s->loaded);
+  }
+  return freelist_new(f, NULL);
+#else // ! TS_USE_FREELIST
+  void *newp = NULL;
+
+  if (f->alignment)
+    newp = ats_memalign(f->alignment, f->chunk_size * f->type_size);
+  else
+    newp = ats_malloc(f->chunk_size * f->type_size);
+  return newp;
+#endif
+}
+
+void
+ink_freelist_free(InkFreeList * f, void *item)
+{
+#if TS_USE_FREELIST
+  if (f->magazine_size) {
+    InkMagazineSlot *s = magazine_slot(f);
+
+    if (s->loaded.count == f->magazine_size) {
+      if (s->previous.count)
+        magazine_depot_push(f, s->previous.head);
+      s->previous = s->loaded;
+      s->loaded.head = NULL;
+      s->loaded.count = 0;
+    }
+#ifdef DEADBEEF
+    {
+      static const char str[4] = { (char) 0xde, (char) 0xad, (char) 0xbe, (char) 0xef };
+
+      for (int j = 0; j < (int)f->type_size; j++)
+        ((char*)item)[j] = str[j % 4];
+    }
+#endif /* DEADBEEF */
+    MAGAZINE_NEXT(item) = s->loaded.head;
+    s->loaded.head = item;
+    s->loaded.count++;
+    return;
+  }
+  freelist_free(f, item);
+#else
+  if (f->alignment)
+    ats_memalign_free(item);
+  else
+    ats_free(item);
+#endif
+}
+
+#if TS_USE_FREELIST
+static void *
+freelist_new(InkFreeList * f, InkMagazine * keep)
+{
   head_p item;
   head_p next;
   int result = 0;
@@ -159,6 +449,7 @@ ink_freelist_new(InkFreeList * f)
     INK_QUEUE_LD64(item, f->head);
     if (TO_PTR(FREELIST_POINTER(item)) == NULL) {
       uint32_t type_size = f->type_size;
+      uint32_t chunk_size = f->chunk_size;
       uint32_t i;
 
 #ifdef MEMPROTECT
@@ -173,31 +464,46 @@ ink_freelist_new(InkFreeList * f)
 #ifdef DEBUG
       char *oldsbrk = (char *) sbrk(0), *newsbrk = NULL;
 #endif
-      if (f->alignment)
-        newp = ats_memalign(f->alignment, f->chunk_size * type_size);
-      else
-        newp = ats_malloc(f->chunk_size * type_size);
-      fl_memadd(f->chunk_size * type_size);
+      if (f->use_hugepages && ats_hugepage_size()) {
+        // fill whole huge pages with items
+        size_t hp = ats_hugepage_size();
+        size_t len = ((size_t) chunk_size * type_size + hp - 1) / hp * hp;
+        if ((newp = ats_alloc_hugepage(len)))
+          chunk_size = len / type_size;
+      }
+      if (!newp) {
+        if (f->alignment)
+          newp = ats_memalign(f->alignment, chunk_size * type_size);
+        else
+          newp = ats_malloc(chunk_size * type_size);
+      }
+      fl_memadd(chunk_size * type_size);
 #ifdef DEBUG
       newsbrk = (char *) sbrk(0);
       ink_atomic_increment(&fastmemtotal, newsbrk - oldsbrk);
-      /*      printf("fastmem %d, %d, %d\n", f->chunk_size * type_size,
+      /*      printf("fastmem %d, %d, %d\n", chunk_size * type_size,
          newsbrk - oldsbrk, fastmemtotal); */
 #endif
       SET_FREELIST_POINTER_VERSION(item, newp, 0);
 
-      ink_atomic_increment((int *) &f->allocated, f->chunk_size);
-      ink_atomic_increment64(&fastalloc_mem_total, (int64_t) f->chunk_size * f->type_size);
+      ink_atomic_increment((int *) &f->allocated, chunk_size);
+      ink_atomic_increment64(&fastalloc_mem_total, (int64_t) chunk_size * f->type_size);
 
-      /* free each of the new elements */
-      for (i = 0; i < f->chunk_size; i++) {
+      /* hand the first element straight back and fill the caller's
+         magazine, then free the rest of the new elements */
+      for (i = 0; i < chunk_size; i++) {
         char *a = ((char *) FREELIST_POINTER(item)) + i * type_size;
 #ifdef DEADBEEF
         const char str[4] = { (char) 0xde, (char) 0xad, (char) 0xbe, (char) 0xef };
         for (int j = 0; j < (int)type_size; j++)
           a[j] = str[j % 4];
 #endif
-        ink_freelist_free(f, a);
+        if (keep && i && keep->count < f->magazine_size) {
+          MAGAZINE_NEXT(a) = keep->head;
+          keep->head = a;
+          keep->count++;
+        } else if (!keep || i)
+          freelist_free(f, a);
 #ifdef MEMPROTECT
         if (f->type_size >= MEMPROTECT_SIZE) {
           a += type_size - page_size;
@@ -207,8 +513,12 @@ ink_freelist_new(InkFreeList * f)
 #endif /* MEMPROTECT */
 
       }
-      ink_atomic_increment((int *) &f->count, f->chunk_size);
-      ink_atomic_increment64(&fastalloc_mem_in_use, (int64_t) f->chunk_size * f->type_size);
+      ink_atomic_increment((int *) &f->count, chunk_size);
+      ink_atomic_increment64(&fastalloc_mem_in_use, (int64_t) chunk_size * f->type_size);
+      // the freed elements uncounted themselves, the first and the
+      // kept ones stay in use
+      if (keep)
+        return newp;
 
     } else {
       SET_FREELIST_POINTER_VERSION(next, *ADDRESS_OF_NEXT(TO_PTR(FREELIST_POINTER(item)), f->offset),
@@ -235,22 +545,15 @@ ink_freelist_new(InkFreeList * f)
   ink_atomic_increment64(&fastalloc_mem_in_use, (int64_t) f->type_size);
 
   return TO_PTR(FREELIST_POINTER(item));
-#else // ! TS_USE_FREELIST
-  void *newp = NULL;
-
-  if (f->alignment)
-    newp = ats_memalign(f->alignment, f->chunk_size * f->type_size);
-  else
-    newp = ats_malloc(f->chunk_size * f->type_size);
-  return newp;
-#endif
 }
+#endif // TS_USE_FREELIST
+
 typedef volatile void *volatile_void_p;
 
-void
-ink_freelist_free(InkFreeList * f, void *item)
-{
 #if TS_USE_FREELIST
+static void
+freelist_free(InkFreeList * f, void *item)
+{
   volatile_void_p *adr_of_next = (volatile_void_p *) ADDRESS_OF_NEXT(item, f->offset);
   head_p h;
   head_p item_pair;
@@ -288,13 +591,8 @@ ink_freelist_free(InkFreeList * f, void *item)
 
   ink_atomic_increment((int *) &f->count, -1);
   ink_atomic_increment64(&fastalloc_mem_in_use, -(int64_t) f->type_size);
-#else
-  if (f->alignment)
-    ats_memalign_free(item);
-  else
-    ats_free(item);
-#endif
 }
+#endif // TS_USE_FREELIST
 
 void
 ink_freelists_snap_baseline()
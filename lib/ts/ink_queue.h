@@ -124,6 +124,11 @@ extern "C"
     const char *name;
     uint32_t type_size, chunk_size, count, allocated, offset, alignment;
     uint32_t allocated_base, count_base;
+    /* per thread magazines, see ink_queue.cc */
+    volatile head_p depot;
+    uint32_t magazine_index, magazine_size;
+    volatile int64_t magazine_hits, magazine_misses;
+    uint32_t use_hugepages;     /* allocate chunks with ats_alloc_hugepage() */
   } InkFreeList, *PInkFreeList;
 
   inkcoreapi extern volatile int64_t fastalloc_mem_in_use;
@@ -143,6 +148,7 @@ extern "C"
   inkcoreapi void ink_freelist_free(InkFreeList * f, void *item);
   void ink_freelists_dump(FILE * f);
   void ink_freelists_dump_baselinerel(FILE * f);
+  void ink_freelists_dump_magazines(FILE * f);
   void ink_freelists_snap_baseline();
 
   typedef struct
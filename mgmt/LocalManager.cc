@@ -1291,6 +1291,14 @@ bindProxyPort(int proxy_port, char *incoming_ip_to_bind_str, int domain, bool tr
     mgmt_elog(stderr, "[bindProxyPort] Unable to set socket options: %d : %s\n", proxy_port, strerror(errno));
     _exit(1);
   }
+#ifdef SO_REUSEPORT
+  // lets the per thread listeners of the proxy join this port
+  bool found;
+  if (type == SOCK_STREAM && REC_readInteger("proxy.config.net.accept_reuseport", &found) > 0 &&
+      setsockopt(proxy_port_fd, SOL_SOCKET, SO_REUSEPORT, (char *) &one, sizeof(int)) < 0) {
+    mgmt_elog(stderr, "[bindProxyPort] Unable to set SO_REUSEPORT: %d : %s\n", proxy_port, strerror(errno));
+  }
+#endif
 
   if (transparent) {
 #if TS_USE_TPROXY
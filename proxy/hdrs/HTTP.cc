@@ -184,6 +184,7 @@ http_init()
 
     mime_init();
     url_init();
+    hdr_heap_init();
 
     HTTP_METHOD_CONNECT = hdrtoken_string_to_wks("CONNECT");
     HTTP_METHOD_DELETE = hdrtoken_string_to_wks("DELETE");
@@ -42,11 +42,35 @@
 #define MAX_LOST_STR_SPACE 1024
 
 Allocator hdrHeapAllocator("hdrHeap", HDR_HEAP_DEFAULT_SIZE);
+static Allocator hdrHeap4KAllocator("hdrHeap4K", HDR_HEAP_DEFAULT_SIZE << 1);
+static Allocator hdrHeap8KAllocator("hdrHeap8K", HDR_HEAP_DEFAULT_SIZE << 2);
+static Allocator hdrHeap16KAllocator("hdrHeap16K", HDR_HEAP_DEFAULT_SIZE << 3);
+static Allocator *hdr_heap_allocators[HDR_HEAP_SIZE_CLASSES] = {
+  &hdrHeapAllocator, &hdrHeap4KAllocator, &hdrHeap8KAllocator, &hdrHeap16KAllocator
+};
 static HdrHeap proto_heap;
 
 Allocator strHeapAllocator("hdrStrHeap", HDR_STR_HEAP_DEFAULT_SIZE);
+static Allocator strHeap4KAllocator("hdrStrHeap4K", HDR_STR_HEAP_DEFAULT_SIZE << 1);
+static Allocator strHeap8KAllocator("hdrStrHeap8K", HDR_STR_HEAP_DEFAULT_SIZE << 2);
+static Allocator strHeap16KAllocator("hdrStrHeap16K", HDR_STR_HEAP_DEFAULT_SIZE << 3);
+static Allocator *str_heap_allocators[HDR_HEAP_SIZE_CLASSES] = {
+  &strHeapAllocator, &strHeap4KAllocator, &strHeap8KAllocator, &strHeap16KAllocator
+};
 static HdrStrHeap str_proto_heap;
 
+// Size class that holds size bytes when the smallest class is
+//   base bytes, HDR_HEAP_SIZE_CLASSES if none does
+static inline int
+hdr_heap_size_class(int size, int base)
+{
+  int c = 0;
+
+  while (c < HDR_HEAP_SIZE_CLASSES && size > (base << c))
+    c++;
+  return c;
+}
+
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
 
@@ -114,6 +138,8 @@ HdrHeap::init()
   m_ronly_heap[2].m_locked = false;
 
   m_lost_string_space = 0;
+  m_grow_count = 0;
+  m_coalesce_count = 0;
 
   ink_assert(m_free_size > 0);
 }
@@ -122,9 +148,11 @@ HdrHeap *
 new_HdrHeap(int size)
 {
   HdrHeap *h;
-  if (size <= HDR_HEAP_DEFAULT_SIZE) {
-    size = HDR_HEAP_DEFAULT_SIZE;
-    h = (HdrHeap *) hdrHeapAllocator.alloc_void();
+  int c = hdr_heap_size_class(size, HDR_HEAP_DEFAULT_SIZE);
+
+  if (c < HDR_HEAP_SIZE_CLASSES) {
+    size = HDR_HEAP_DEFAULT_SIZE << c;
+    h = (HdrHeap *) hdr_heap_allocators[c]->alloc_void();
   } else {
     h = (HdrHeap *)ats_malloc(size);
   }
@@ -152,9 +180,11 @@ new_HdrStrHeap(int requested_size)
   int alloc_size = requested_size + sizeof(HdrStrHeap);
 
   HdrStrHeap *sh;
-  if (alloc_size <= HDR_STR_HEAP_DEFAULT_SIZE) {
-    alloc_size = HDR_STR_HEAP_DEFAULT_SIZE;
-    sh = (HdrStrHeap *) strHeapAllocator.alloc_void();
+  int c = hdr_heap_size_class(alloc_size, HDR_STR_HEAP_DEFAULT_SIZE);
+
+  if (c < HDR_HEAP_SIZE_CLASSES) {
+    alloc_size = HDR_STR_HEAP_DEFAULT_SIZE << c;
+    sh = (HdrStrHeap *) str_heap_allocators[c]->alloc_void();
   } else {
     alloc_size = ROUND(alloc_size, HDR_STR_HEAP_DEFAULT_SIZE*2);
     sh = (HdrStrHeap *)ats_malloc(alloc_size);
@@ -179,6 +209,139 @@ new_HdrStrHeap(int requested_size)
   return sh;
 }
 
+/*-------------------------------------------------------------------------
+  -------------------------------------------------------------------------*/
+
+// Heap size learning
+//
+//    Each thread keeps a histogram per HdrHeapUse of the object and
+//      string space its recent headers ended up using, by size class.
+//      Every HDR_HEAP_SIZE_SAMPLES headers the sizes handed out move to
+//      the smallest classes that would have held HDR_HEAP_SIZE_COVER
+//      percent of them, and the counts are halved so older traffic
+//      fades out.  A string heap is only preallocated when more than
+//      HDR_HEAP_STR_PREALLOC percent of the headers needed one, and is
+//      then sized to cover those.
+//
+#define HDR_HEAP_SIZE_SAMPLES 64
+#define HDR_HEAP_SIZE_COVER 90
+#define HDR_HEAP_STR_PREALLOC 50
+
+struct HdrHeapSizeHist
+{
+  uint32_t obj[HDR_HEAP_SIZE_CLASSES + 1];      // by class, last is too big for all
+  uint32_t str[HDR_HEAP_SIZE_CLASSES + 2];      // no strings, by class, too big
+  uint32_t samples;
+  int obj_size;                 // heap size to allocate
+  int str_size;                 // string heap to allocate with it, 0 for none
+};
+
+static ink_thread_key hdr_heap_size_key;
+
+void
+hdr_heap_init()
+{
+  static int init = 1;
+
+  if (init) {
+    init = 0;
+    ink_thread_key_create(&hdr_heap_size_key, ats_free);
+  }
+}
+
+static HdrHeapSizeHist *
+hdr_heap_size_hist(HdrHeapUse use)
+{
+  HdrHeapSizeHist *h = (HdrHeapSizeHist *) ink_thread_getspecific(hdr_heap_size_key);
+
+  if (unlikely(!h)) {
+    h = (HdrHeapSizeHist *) ats_calloc(HDR_HEAP_USES, sizeof(HdrHeapSizeHist));
+    for (int i = 0; i < HDR_HEAP_USES; i++)
+      h[i].obj_size = HDR_HEAP_DEFAULT_SIZE;
+    ink_thread_setspecific(hdr_heap_size_key, h);
+  }
+  return &h[use];
+}
+
+static int
+hdr_heap_size_cover(uint32_t *counts, int n, uint32_t total)
+{
+  uint32_t sum = 0;
+
+  for (int i = 0; i < n - 1; i++) {
+    sum += counts[i];
+    if (sum * 100 >= total * HDR_HEAP_SIZE_COVER)
+      return i;
+  }
+  return n - 1;
+}
+
+static inline int
+hdr_str_heap_used(HdrStrHeap * sh)
+{
+  return (int) (sh->m_heap_size - sh->m_free_size - STR_HEAP_HDR_SIZE);
+}
+
+HdrHeap *
+new_HdrHeap_sized(HdrHeapUse use)
+{
+  HdrHeapSizeHist *h = hdr_heap_size_hist(use);
+  HdrHeap *heap = new_HdrHeap(h->obj_size);
+
+  if (h->str_size)
+    heap->m_read_write_heap = new_HdrStrHeap(h->str_size - STR_HEAP_HDR_SIZE);
+  return heap;
+}
+
+void
+hdr_heap_size_observe(HdrHeapUse use, HdrHeap * heap)
+{
+  HdrHeapSizeHist *h = hdr_heap_size_hist(use);
+  int obj_used = HDR_HEAP_HDR_SIZE;
+  int str_used = 0;
+  int i;
+
+  for (HdrHeap * o = heap; o; o = o->m_next)
+    obj_used += (int) (o->m_free_start - o->m_data_start);
+
+  if (heap->m_read_write_heap)
+    str_used += hdr_str_heap_used(heap->m_read_write_heap);
+  // Demoted string heaps start at their own header, the other
+  //   read only heaps point into IOBuffer blocks
+  for (i = 0; i < HDR_BUF_RONLY_HEAPS; i++) {
+    StrHeapDesc *d = &heap->m_ronly_heap[i];
+    if (d->m_heap_start && d->m_heap_start == (char *) d->m_ref_count_ptr.m_ptr)
+      str_used += hdr_str_heap_used((HdrStrHeap *) d->m_ref_count_ptr.m_ptr);
+  }
+
+  h->obj[hdr_heap_size_class(obj_used, HDR_HEAP_DEFAULT_SIZE)]++;
+  h->str[str_used ? 1 + hdr_heap_size_class(str_used + STR_HEAP_HDR_SIZE, HDR_STR_HEAP_DEFAULT_SIZE) : 0]++;
+
+  if (++h->samples >= HDR_HEAP_SIZE_SAMPLES) {
+    uint32_t total = 0;
+    int c;
+
+    for (i = 0; i <= HDR_HEAP_SIZE_CLASSES; i++)
+      total += h->obj[i];
+
+    c = hdr_heap_size_cover(h->obj, HDR_HEAP_SIZE_CLASSES + 1, total);
+    h->obj_size = HDR_HEAP_DEFAULT_SIZE << (c < HDR_HEAP_SIZE_CLASSES ? c : HDR_HEAP_SIZE_CLASSES - 1);
+    uint32_t with_str = total - h->str[0];
+    if (with_str * 100 > total * HDR_HEAP_STR_PREALLOC) {
+      c = hdr_heap_size_cover(h->str + 1, HDR_HEAP_SIZE_CLASSES + 1, with_str);
+      h->str_size = HDR_STR_HEAP_DEFAULT_SIZE << (c < HDR_HEAP_SIZE_CLASSES ? c : HDR_HEAP_SIZE_CLASSES - 1);
+    } else
+      h->str_size = 0;
+    Debug("hdrs", "header heap use %d sized to %d, string heap %d", use, h->obj_size, h->str_size);
+
+    for (i = 0; i <= HDR_HEAP_SIZE_CLASSES; i++)
+      h->obj[i] /= 2;
+    for (i = 0; i <= HDR_HEAP_SIZE_CLASSES + 1; i++)
+      h->str[i] /= 2;
+    h->samples = 0;
+  }
+}
+
 void
 HdrHeap::destroy()
 {
@@ -191,8 +354,10 @@ HdrHeap::destroy()
   m_ronly_heap[1].m_ref_count_ptr = NULL;
   m_ronly_heap[2].m_ref_count_ptr = NULL;
 
-  if (m_size == HDR_HEAP_DEFAULT_SIZE) {
-    hdrHeapAllocator.free_void(this);
+  int c = hdr_heap_size_class(m_size, HDR_HEAP_DEFAULT_SIZE);
+
+  if (c < HDR_HEAP_SIZE_CLASSES && m_size == (uint32_t) (HDR_HEAP_DEFAULT_SIZE << c)) {
+    hdr_heap_allocators[c]->free_void(this);
   } else {
     ats_free(this);
   }
@@ -236,6 +401,7 @@ HdrHeap::allocate_obj(int nbytes, int type)
       //   number of pointer heaps is O(log n)
       //   with regard to number of bytes allocated
       h->m_next = new_HdrHeap(h->m_size * 2);
+      count_grow();
     }
 
     h = h->m_next;
@@ -277,6 +443,8 @@ RETRY:
     int next_size = (last_size * 2) - STR_HEAP_HDR_SIZE;
     next_size = next_size > nbytes ? next_size : nbytes;
     m_read_write_heap = new_HdrStrHeap(next_size);
+    if (last_size)
+      count_grow();
   }
   // Try to allocate of our read/write string heap
   new_space = m_read_write_heap->allocate(nbytes);
@@ -389,6 +557,9 @@ HdrHeap::coalesce_str_heaps(int incoming_size)
   ink_assert(incoming_size >= 0);
   ink_assert(m_writeable);
 
+  if (m_coalesce_count != 0xFF)
+    m_coalesce_count++;
+
   if (m_read_write_heap) {
     new_heap_size += m_read_write_heap->m_heap_size;
   }
@@ -667,6 +838,8 @@ HdrHeap::marshal(char *buf, int len)
   marshal_hdr->m_data_start = (char *) HDR_HEAP_HDR_SIZE;       // offset
   marshal_hdr->m_magic = HDR_BUF_MAGIC_MARSHALED;
   marshal_hdr->m_writeable = false;
+  marshal_hdr->m_grow_count = 0;
+  marshal_hdr->m_coalesce_count = 0;
   marshal_hdr->m_size = ptr_heap_size + HDR_HEAP_HDR_SIZE;
   marshal_hdr->m_next = NULL;
   marshal_hdr->m_free_size = 0;
@@ -1124,8 +1297,10 @@ HdrHeap::dump_heap(int len)
 void
 HdrStrHeap::free()
 {
-  if (m_heap_size == HDR_STR_HEAP_DEFAULT_SIZE) {
-    strHeapAllocator.free_void(this);
+  int c = hdr_heap_size_class(m_heap_size, HDR_STR_HEAP_DEFAULT_SIZE);
+
+  if (c < HDR_HEAP_SIZE_CLASSES && m_heap_size == (uint32_t) (HDR_STR_HEAP_DEFAULT_SIZE << c)) {
+    str_heap_allocators[c]->free_void(this);
   } else {
     ats_free(this);
   }
@@ -58,6 +58,10 @@
 #define HDR_HEAP_DEFAULT_SIZE   2048
 #define HDR_STR_HEAP_DEFAULT_SIZE   2048
 
+// Heaps (and string heaps) up to HDR_HEAP_DEFAULT_SIZE << (classes - 1)
+//  come from per size class allocators, bigger ones are malloced
+#define HDR_HEAP_SIZE_CLASSES   4
+
 enum
 {
   HDR_HEAP_OBJ_EMPTY = 0,
@@ -234,6 +238,12 @@ public:
 
   bool m_writeable;
 
+  // Growth accounting for the stats, saturating.  These live in
+  //   the padding after m_writeable so the marshalled layout of
+  //   the heap doesn't change
+  uint8_t m_grow_count;         // overflow blocks and string heaps added
+  uint8_t m_coalesce_count;     // string heap coalesces
+
   // Overflow block ptr
   //   Overflow blocks are necessary because we can
   //     run out of space in the header heap and the
@@ -246,6 +256,7 @@ public:
   // HdrBuf heap pointers
   uint32_t m_free_size;
 
+  void count_grow();
   int demote_rw_str_heap();
   void coalesce_str_heaps(int incoming_size = 0);
   void evacuate_from_str_heaps(HdrStrHeap * new_heap);
@@ -258,6 +269,13 @@ public:
 
 };
 
+inline void
+HdrHeap::count_grow()
+{
+  if (m_grow_count != 0xFF)
+    m_grow_count++;
+}
+
 inline void
 HdrHeap::free_string(const char *s, int len)
 {
@@ -449,5 +467,18 @@ HdrHeapSDKHandle::set(const HdrHeapSDKHandle * from)
 
 inkcoreapi HdrHeap *new_HdrHeap(int size = HDR_HEAP_DEFAULT_SIZE);
 
+// Headers whose heap size each thread learns from the ones it has
+//   seen, so that most of them get a heap that never has to grow
+enum HdrHeapUse
+{
+  HDR_HEAP_USE_CLIENT_REQUEST,
+  HDR_HEAP_USE_SERVER_RESPONSE,
+  HDR_HEAP_USES
+};
+
+void hdr_heap_init();
+HdrHeap *new_HdrHeap_sized(HdrHeapUse use);
+void hdr_heap_size_observe(HdrHeapUse use, HdrHeap * heap);
+
 void hdr_heap_test();
 #endif
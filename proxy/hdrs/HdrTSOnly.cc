@@ -44,6 +44,23 @@
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
 
+// static bool hold_partial_line(IOBufferReader* r, IOBufferBlock* b, int64_t b_avail)
+//
+//    The string heaps reference the parsed lines in the IOBuffer block
+//      itself, except for lines that straddle two reads which the scanner
+//      has to copy aside.  When the block holds the last of the data and
+//      has room left, the next read lands right after it, so the parser
+//      can leave an unfinished line in the reader and pick it up whole
+//      next time.  A full block (or data beyond it) means the line will
+//      continue elsewhere and has to be copied as before; this also keeps
+//      the held bytes below one block so the reader can't stall the VIO.
+//
+static inline bool
+hold_partial_line(IOBufferReader * r, IOBufferBlock * b, int64_t b_avail)
+{
+  return b->write_avail() > 0 && b_avail == r->read_avail();
+}
+
 MIMEParseResult
 HTTPHdr::parse_req(HTTPParser * parser, IOBufferReader * r, int *bytes_used, bool eof)
 {
@@ -70,10 +87,13 @@ HTTPHdr::parse_req(HTTPParser * parser, IOBufferReader * r, int *bytes_used, boo
     tmp = start = r->start();
     end = start + b_avail;
 
-    int heap_slot = m_heap->attach_block(r->get_current_block(), start);
+    IOBufferBlock *b = r->get_current_block();
+    int heap_slot = m_heap->attach_block(b, start);
 
     m_heap->lock_ronly_str_heap(heap_slot);
+    parser->m_mime_parser.m_scanner.m_hold_partial = hold_partial_line(r, b, b_avail);
     state = http_parser_parse_req(parser, m_heap, m_http, &tmp, end, false, eof);
+    parser->m_mime_parser.m_scanner.m_hold_partial = false;
     m_heap->set_ronly_str_heap_end(heap_slot, tmp);
     m_heap->unlock_ronly_str_heap(heap_slot);
 
@@ -81,6 +101,9 @@ HTTPHdr::parse_req(HTTPParser * parser, IOBufferReader * r, int *bytes_used, boo
     r->consume(used);
     *bytes_used += used;
 
+    // An unfinished line was left in the block, wait for the rest of it.
+    if (used < b_avail)
+      break;
   } while (state == PARSE_CONT);
 
   return state;
@@ -110,10 +133,13 @@ HTTPHdr::parse_resp(HTTPParser * parser, IOBufferReader * r, int *bytes_used, bo
     tmp = start = r->start();
     end = start + b_avail;
 
-    int heap_slot = m_heap->attach_block(r->get_current_block(), start);
+    IOBufferBlock *b = r->get_current_block();
+    int heap_slot = m_heap->attach_block(b, start);
 
     m_heap->lock_ronly_str_heap(heap_slot);
+    parser->m_mime_parser.m_scanner.m_hold_partial = hold_partial_line(r, b, b_avail);
     state = http_parser_parse_resp(parser, m_heap, m_http, &tmp, end, false, eof);
+    parser->m_mime_parser.m_scanner.m_hold_partial = false;
     m_heap->set_ronly_str_heap_end(heap_slot, tmp);
     m_heap->unlock_ronly_str_heap(heap_slot);
 
@@ -121,6 +147,9 @@ HTTPHdr::parse_resp(HTTPParser * parser, IOBufferReader * r, int *bytes_used, bo
     r->consume(used);
     *bytes_used += used;
 
+    // An unfinished line was left in the block, wait for the rest of it.
+    if (used < b_avail)
+      break;
   } while (state == PARSE_CONT);
 
   return state;
@@ -190,6 +219,13 @@ RETRY:
 //                 m_ronly_heap[i].m_heap_len,
 //                 i);
       return i;
+    } else if (m_ronly_heap[i].m_ref_count_ptr.m_ptr == b->data.m_ptr &&
+               m_ronly_heap[i].m_heap_start + m_ronly_heap[i].m_heap_len == use_start) {
+      // The part of the block we use picks up where the last
+      //   parse stopped, extend that range rather than taking
+      //   another slot that would eventually force a coalesce
+      m_ronly_heap[i].m_heap_len = (int) (b->end() - m_ronly_heap[i].m_heap_start);
+      return i;
     }
   }
 
@@ -197,3 +233,60 @@ RETRY:
   coalesce_str_heaps();
   goto RETRY;
 }
+
+#if TS_HAS_TESTS
+// Feed a request to the parser a few bytes at a time, the way slow
+//   clients deliver it, and check that every split parses to the same
+//   header.  Within one block nothing may be copied to the string heap.
+REGRESSION_TEST(HdrTSOnly_parse_in_place) (RegressionTest * t, int atype, int *pstatus) {
+  NOWARN_UNUSED(atype);
+  static const char request[] =
+    "GET http://www.example.com/a/b/index.html?x=1 HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64)\r\n"
+    "Accept: text/html,\r\n"
+    "  application/xml\r\n" "Cookie: id=12345; session=abcdef\r\n" "\r\n";
+  // block sizes: all in one block, or spread over several
+  static const int64_t size_index[] = { BUFFER_SIZE_INDEX_4K, BUFFER_SIZE_INDEX_128 };
+  int len = (int) sizeof(request) - 1;
+  int ok = 1;
+
+  *pstatus = REGRESSION_TEST_INPROGRESS;
+  for (int s = 0; s < 2; s++) {
+    for (int chunk = 1; chunk <= len && ok; chunk++) {
+      MIOBuffer *buf = new_MIOBuffer(size_index[s]);
+      IOBufferReader *reader = buf->alloc_reader();
+      MIMEParseResult state = PARSE_CONT;
+      HTTPParser parser;
+      HTTPHdr hdr;
+      int used, total = 0, vlen = 0, plen = 0;
+      const char *v, *p;
+
+      http_parser_init(&parser);
+      hdr.create(HTTP_TYPE_REQUEST);
+      for (int off = 0; off < len && state == PARSE_CONT; off += chunk) {
+        buf->write(request + off, chunk < len - off ? chunk : len - off);
+        state = hdr.parse_req(&parser, reader, &used, false);
+        total += used;
+      }
+
+      v = hdr.value_get(MIME_FIELD_ACCEPT, MIME_LEN_ACCEPT, &vlen);
+      p = hdr.url_get()->path_get(&plen);
+      if (state != PARSE_DONE || total != len || !v || !p || ptr_len_cmp(v, vlen, "text/html,\r\n  application/xml") != 0 ||
+          ptr_len_cmp(p, plen, "a/b/index.html") != 0 || hdr.fields_count() != 4) {
+        rprintf(t, "block index %d, chunks of %d: parse state %d, used %d of %d\n", (int) size_index[s], chunk, state,
+                total, len);
+        ok = 0;
+      } else if (s == 0 && hdr.m_heap->m_read_write_heap) {
+        rprintf(t, "chunks of %d: header strings were copied\n", chunk);
+        ok = 0;
+      }
+
+      http_parser_clear(&parser);
+      hdr.destroy();
+      free_MIOBuffer(buf);
+    }
+  }
+  *pstatus = ok ? REGRESSION_TEST_PASSED : REGRESSION_TEST_FAILED;
+}
+#endif
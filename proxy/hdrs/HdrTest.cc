@@ -51,7 +51,6 @@
 int
 HdrTest::go(RegressionTest * t, int atype)
 {
-  NOWARN_UNUSED(atype);
   HdrTest::rtest = t;
 
   int status = 1;
@@ -80,6 +79,11 @@ HdrTest::go(RegressionTest * t, int atype)
   status = status & test_http_mutation();
   status = status & test_mime();
   status = status & test_http();
+  status = status & test_mime_scan();
+  status = status & test_parse_bench(atype);
+  status = status & test_hdrtoken_bench(atype);
+  status = status & test_field_find_bench(atype);
+  status = status & test_hdr_heap_sizing();
 
   return (status ? REGRESSION_TEST_PASSED : REGRESSION_TEST_FAILED);
 }
@@ -2189,6 +2193,446 @@ HdrTest::test_parse_comma_list()
   return (failures_to_status("test_parse_comma_list", failures));
 }
 
+/*-------------------------------------------------------------------------
+  -------------------------------------------------------------------------*/
+
+int
+HdrTest::test_mime_scan()
+{
+  static const char mime[] =
+    "Host: www.example.com\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:10.0) Gecko/20100101 Firefox/10.0\r\n"
+    "continuation\r\n"
+    " part1: part2\r\n"
+    "Accept-Language: en-us,en;q=0.5\r\n"
+    "x:\r\n"
+    "garbage line without a separator, long enough for a couple of vectors\r\n"
+    "Cookie: a=b; c=d:e\r\n"
+    "\r\n";
+  int failures = 0;
+  int len = (int) strlen(mime);
+  char full[2048], split[2048];
+  int full_len = 0;
+
+  bri_box("test_mime_scan");
+
+  // mime_scan_lf against a byte at a time search, at every start offset
+  for (int i = 0; i < len; i++) {
+    const char *colon = NULL, *c = NULL;
+    const char *lf = mime_scan_lf(mime + i, mime + len, &colon);
+    const char *x = (const char *) memchr(mime + i, '\n', len - i);
+    for (const char *p = mime + i; p < x; p++) {
+      if (*p == ':') {
+        c = p;
+        break;
+      }
+    }
+    if (lf != x || colon != c) {
+      printf("FAILED: mime_scan_lf at offset %d\n", i);
+      ++failures;
+    }
+  }
+
+  // the header must come out the same however the input is split up
+  for (int chunk = 0; chunk < len; chunk++) {
+    MIMEHdr hdr;
+    MIMEParser parser;
+    const char *start = mime, *end;
+    int err = PARSE_CONT, index = 0, offset = 0;
+
+    mime_parser_init(&parser);
+    hdr.create(NULL);
+    while (err == PARSE_CONT && start < mime + len) {
+      end = chunk ? start + chunk : mime + len;
+      if (end > mime + len)
+        end = mime + len;
+      err = hdr.parse(&parser, &start, end, true, end == mime + len);
+    }
+    hdr.print(chunk ? split : full, sizeof(full), &index, &offset);
+    if (!chunk) {
+      full_len = index;
+      printf("fields: %d\n%.*s\n", hdr.fields_count(), full_len, full);
+    } else if (err < 0 || index != full_len || memcmp(full, split, index)) {
+      printf("FAILED: parse in chunks of %d\n", chunk);
+      ++failures;
+    }
+    mime_parser_clear(&parser);
+    hdr.destroy();
+  }
+
+  return (failures_to_status("test_mime_scan", failures));
+}
+
+/*-------------------------------------------------------------------------
+  -------------------------------------------------------------------------*/
+
+int
+HdrTest::test_parse_bench(int atype)
+{
+  // A sample of request and response headers as seen on a forward proxy.
+  static const char *corpus[] = {
+    "GET http://www.example.com/index.html HTTP/1.1\r\n"
+      "Host: www.example.com\r\n"
+      "User-Agent: Mozilla/5.0 (Windows NT 6.1; WOW64) AppleWebKit/535.7 (KHTML, like Gecko) Chrome/16.0.912.63 Safari/535.7\r\n"
+      "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+      "Accept-Encoding: gzip,deflate,sdch\r\n"
+      "Accept-Language: en-US,en;q=0.8\r\n"
+      "Accept-Charset: ISO-8859-1,utf-8;q=0.7,*;q=0.3\r\n"
+      "Cookie: __utma=173272373.1108413926.1324507432.1326836434.1326997478.12; __utmz=173272373.1324507432.1.1.utmcsr=(direct)\r\n"
+      "Connection: keep-alive\r\n"
+      "\r\n",
+    "GET /images/logo_sm.gif HTTP/1.1\r\n"
+      "Host: static.example.com\r\n"
+      "Referer: http://www.example.com/index.html\r\n"
+      "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:9.0.1) Gecko/20100101 Firefox/9.0.1\r\n"
+      "Accept: image/png,image/*;q=0.8,*/*;q=0.5\r\n"
+      "If-Modified-Since: Tue, 10 Jan 2012 18:31:07 GMT\r\n"
+      "If-None-Match: \"7d0f6-5a2-4b6304cc2fdc0\"\r\n"
+      "Cache-Control: max-age=0\r\n"
+      "\r\n",
+    "POST /api/v1/update HTTP/1.1\r\n"
+      "Host: api.example.com\r\n"
+      "Content-Type: application/x-www-form-urlencoded; charset=UTF-8\r\n"
+      "Content-Length: 184\r\n"
+      "X-Requested-With: XMLHttpRequest\r\n"
+      "Origin: http://www.example.com\r\n"
+      "Via: 1.1 proxy1.example.net\r\n"
+      "X-Forwarded-For: 10.1.2.3, 192.168.5.6\r\n"
+      "\r\n",
+    "HTTP/1.1 200 OK\r\n"
+      "Date: Fri, 20 Jan 2012 18:01:23 GMT\r\n"
+      "Server: Apache/2.2.21 (Unix)\r\n"
+      "Last-Modified: Tue, 10 Jan 2012 18:31:07 GMT\r\n"
+      "ETag: \"7d0f6-5a2-4b6304cc2fdc0\"\r\n"
+      "Accept-Ranges: bytes\r\n"
+      "Content-Length: 1442\r\n"
+      "Cache-Control: max-age=86400, public\r\n"
+      "Expires: Sat, 21 Jan 2012 18:01:23 GMT\r\n"
+      "Vary: Accept-Encoding\r\n"
+      "Keep-Alive: timeout=5, max=100\r\n"
+      "Connection: Keep-Alive\r\n"
+      "Content-Type: image/gif\r\n"
+      "\r\n",
+    "HTTP/1.1 302 Found\r\n"
+      "Date: Fri, 20 Jan 2012 18:01:24 GMT\r\n"
+      "Location: http://www.example.com/login?return=%2Faccount%2Fsettings\r\n"
+      "Set-Cookie: session=8f14e45fceea167a5a36dedd4bea2543; path=/; expires=Sat, 21-Jan-2012 18:01:24 GMT; HttpOnly\r\n"
+      "Content-Length: 0\r\n"
+      "P3P: CP=\"NOI DSP COR NID CURa ADMa DEVa PSAa PSDa OUR BUS COM INT OTC PUR STA\"\r\n"
+      "\r\n",
+  };
+  int ncorpus = (int) (sizeof(corpus) / sizeof(corpus[0]));
+  int iterations = atype >= REGRESSION_TEST_EXTENDED ? 1000000 : 20000;
+  int failures = 0, nfields = 0;
+  int64_t bytes = 0;
+  ink_hrtime t0, elapsed;
+  HTTPParser parser;
+
+  bri_box("test_parse_bench");
+
+  http_parser_init(&parser);
+  t0 = ink_get_hrtime_internal();
+  for (int i = 0; i < iterations; i++) {
+    for (int j = 0; j < ncorpus; j++) {
+      HTTPHdr hdr;
+      const char *start = corpus[j];
+      const char *end = start + strlen(start);
+      int err;
+
+      if (corpus[j][0] == 'H') {
+        hdr.create(HTTP_TYPE_RESPONSE);
+        err = hdr.parse_resp(&parser, &start, end, true);
+      } else {
+        hdr.create(HTTP_TYPE_REQUEST);
+        err = hdr.parse_req(&parser, &start, end, true);
+      }
+      if (err != PARSE_DONE)
+        ++failures;
+      if (!i) {
+        nfields += hdr.fields_count();
+        bytes += end - corpus[j];
+      }
+      http_parser_clear(&parser);
+      hdr.destroy();
+    }
+  }
+  elapsed = ink_get_hrtime_internal() - t0;
+
+  rprintf(rtest, "  HdrTest test_parse_bench: %d headers, %d fields, %" PRId64 " bytes, %d iterations\n",
+          ncorpus, nfields, bytes, iterations);
+  rprintf(rtest, "  HdrTest test_parse_bench: %" PRId64 " ns/header, %" PRId64 " ns/field\n",
+          (int64_t) (elapsed / ((int64_t) iterations * ncorpus)), (int64_t) (elapsed / ((int64_t) iterations * nfields)));
+
+  return (failures_to_status("test_parse_bench", failures));
+}
+
+/*-------------------------------------------------------------------------
+  -------------------------------------------------------------------------*/
+
+int
+HdrTest::test_hdrtoken_bench(int atype)
+{
+  // Field names and methods as they show up in requests and responses,
+  // including some that are not well-known strings.
+  static const char *names[] = {
+    "GET", "POST", "Host", "User-Agent", "Accept", "Accept-Encoding", "Accept-Language",
+    "Accept-Charset", "Cookie", "Connection", "Referer", "If-Modified-Since", "If-None-Match",
+    "Cache-Control", "Content-Type", "Content-Length", "X-Requested-With", "Origin", "Via",
+    "X-Forwarded-For", "Date", "Server", "Last-Modified", "ETag", "Accept-Ranges", "Expires",
+    "Vary", "Keep-Alive", "Location", "Set-Cookie", "P3P", "X-Cache", "Age", "DNT",
+    "content-length", "TRANSFER-ENCODING",
+  };
+  int nnames = (int) (sizeof(names) / sizeof(names[0]));
+  int iterations = atype >= REGRESSION_TEST_EXTENDED ? 1000000 : 20000;
+  int failures = 0, found = 0;
+  char buf[128];
+  ink_hrtime t0, hash_ns, dfa_ns;
+  DFA dfa;
+
+  bri_box("test_hdrtoken_bench");
+
+  // every well-known string must be found in any case
+  for (int i = 0; i < hdrtoken_num_wks; i++) {
+    int len = hdrtoken_str_lengths[i];
+
+    for (int j = 0; j < len; j++)
+      buf[j] = ParseRules::ink_tolower(hdrtoken_strs[i][j]);
+    if (hdrtoken_tokenize(buf, len) != i) {
+      printf("FAILED: '%.*s' is not well-known string %d\n", len, buf, i);
+      ++failures;
+    }
+    for (int j = 0; j < len; j++)
+      buf[j] = ParseRules::ink_toupper(hdrtoken_strs[i][j]);
+    if (hdrtoken_tokenize(buf, len) != i) {
+      printf("FAILED: '%.*s' is not well-known string %d\n", len, buf, i);
+      ++failures;
+    }
+    // near misses are only found if they are well-known strings too
+    buf[len - 1] ^= 1;
+    for (int l = len; l >= len - 1; l--) {
+      int k = hdrtoken_tokenize(buf, l);
+      if (k >= 0 && ptr_len_casecmp(hdrtoken_strs[k], hdrtoken_str_lengths[k], buf, l) != 0) {
+        printf("FAILED: '%.*s' found as '%s'\n", l, buf, hdrtoken_strs[k]);
+        ++failures;
+      }
+    }
+  }
+
+  // the DFA that used to resolve the well-known strings
+  dfa.compile(hdrtoken_strs, hdrtoken_num_wks, RE_CASE_INSENSITIVE);
+
+  t0 = ink_get_hrtime_internal();
+  for (int i = 0; i < iterations; i++)
+    for (int j = 0; j < nnames; j++)
+      found += hdrtoken_tokenize(names[j], (int) strlen(names[j])) >= 0;
+  hash_ns = ink_get_hrtime_internal() - t0;
+
+  t0 = ink_get_hrtime_internal();
+  for (int i = 0; i < iterations; i++)
+    for (int j = 0; j < nnames; j++)
+      found += dfa.match(names[j], (int) strlen(names[j])) >= 0;
+  dfa_ns = ink_get_hrtime_internal() - t0;
+
+  rprintf(rtest, "  HdrTest test_hdrtoken_bench: %d names, %d iterations, %d found\n", nnames, iterations, found);
+  rprintf(rtest, "  HdrTest test_hdrtoken_bench: hash %" PRId64 " ns/name, dfa %" PRId64 " ns/name\n",
+          (int64_t) (hash_ns / ((int64_t) iterations * nnames)), (int64_t) (dfa_ns / ((int64_t) iterations * nnames)));
+
+  return (failures_to_status("test_hdrtoken_bench", failures));
+}
+
+/*-------------------------------------------------------------------------
+  -------------------------------------------------------------------------*/
+
+int
+HdrTest::test_field_find_bench(int atype)
+{
+  // More fields than fit in the first field block, so some of them
+  // are found through the second one.
+  static const char mime[] =
+    "Date: Mon, 02 Apr 2012 20:11:51 GMT\r\n"
+    "Server: Apache\r\n"
+    "Last-Modified: Mon, 02 Apr 2012 19:10:00 GMT\r\n"
+    "ETag: \"6f0d-4bcb7ffd\"\r\n"
+    "Accept-Ranges: bytes\r\n"
+    "Cache-Control: max-age=3600\r\n"
+    "Expires: Mon, 02 Apr 2012 21:11:51 GMT\r\n"
+    "Vary: Accept-Encoding\r\n"
+    "Content-Encoding: gzip\r\n"
+    "Content-Length: 9032\r\n"
+    "Keep-Alive: timeout=5, max=100\r\n"
+    "Connection: Keep-Alive\r\n"
+    "Content-Type: text/html\r\n"
+    "X-Cache: MISS\r\n"
+    "Age: 0\r\n"
+    "Set-Cookie: a=b\r\n"
+    "Set-Cookie: c=d\r\n"
+    "Location: http://example.com/\r\n"
+    "Content-Language: en\r\n"
+    "Content-Location: /index.html\r\n"
+    "Via: 1.1 proxy\r\n"
+    "WWW-Authenticate: Basic\r\n"
+    "Warning: 110\r\n"
+    "X-Powered-By: PHP\r\n"
+    "\r\n";
+  static const char *present[] = {
+    "Date", "server", "ETAG", "Content-Length", "X-Cache", "Set-Cookie", "Location", "Content-Language", "Via",
+    "Warning", "x-powered-by",
+  };
+  static const char *absent[] = {
+    "Host", "Cookie", "Range", "If-Modified-Since", "Transfer-Encoding", "Proxy-Connection", "Pragma",
+    "Accept-Charset", "Content-MD5", "X-Forwarded-For", "X-Not-There",
+  };
+  int npresent = (int) (sizeof(present) / sizeof(present[0]));
+  int nabsent = (int) (sizeof(absent) / sizeof(absent[0]));
+  int iterations = atype >= REGRESSION_TEST_EXTENDED ? 1000000 : 20000;
+  int failures = 0, found = 0, length;
+  const char *start = mime, *end = mime + sizeof(mime) - 1;
+  ink_hrtime t0, present_ns, absent_ns;
+  MIMEField *field;
+  MIMEParser parser;
+  MIMEHdr hdr;
+
+  bri_box("test_field_find_bench");
+
+  mime_parser_init(&parser);
+  hdr.create(NULL);
+  if (hdr.parse(&parser, &start, end, false, false) != PARSE_DONE) {
+    printf("FAILED: could not parse header\n");
+    mime_parser_clear(&parser);
+    hdr.destroy();
+    return (failures_to_status("test_field_find_bench", 1));
+  }
+  mime_parser_clear(&parser);
+
+  for (int i = 0; i < npresent; i++) {
+    const char *name = NULL;
+
+    length = 0;
+    field = hdr.field_find(present[i], (int) strlen(present[i]));
+    if (field)
+      name = field->name_get(&length);
+    if (field == NULL || ptr_len_casecmp(name, length, present[i], (int) strlen(present[i])) != 0) {
+      printf("FAILED: '%s' not found\n", present[i]);
+      ++failures;
+    }
+  }
+  for (int i = 0; i < nabsent; i++) {
+    if (hdr.field_find(absent[i], (int) strlen(absent[i])) != NULL) {
+      printf("FAILED: '%s' found\n", absent[i]);
+      ++failures;
+    }
+  }
+  if (hdr.m_field_lookups != npresent + nabsent) {
+    printf("FAILED: %d field lookups counted, expected %d\n", hdr.m_field_lookups, npresent + nabsent);
+    ++failures;
+  }
+  // the duplicate head moves to the next Set-Cookie when it is removed
+  field = hdr.field_find(MIME_FIELD_SET_COOKIE, MIME_LEN_SET_COOKIE);
+  hdr.field_delete(field, false);
+  field = hdr.field_find(MIME_FIELD_SET_COOKIE, MIME_LEN_SET_COOKIE);
+  if (field == NULL || field->m_next_dup != NULL) {
+    printf("FAILED: second Set-Cookie not found\n");
+    ++failures;
+  }
+  hdr.field_delete(MIME_FIELD_WARNING, MIME_LEN_WARNING);
+  if (hdr.field_find(MIME_FIELD_WARNING, MIME_LEN_WARNING) != NULL) {
+    printf("FAILED: deleted Warning found\n");
+    ++failures;
+  }
+
+  t0 = ink_get_hrtime_internal();
+  for (int i = 0; i < iterations; i++)
+    for (int j = 0; j < npresent; j++)
+      found += hdr.field_find(present[j], (int) strlen(present[j])) != NULL;
+  present_ns = ink_get_hrtime_internal() - t0;
+
+  t0 = ink_get_hrtime_internal();
+  for (int i = 0; i < iterations; i++)
+    for (int j = 0; j < nabsent; j++)
+      found += hdr.field_find(absent[j], (int) strlen(absent[j])) != NULL;
+  absent_ns = ink_get_hrtime_internal() - t0;
+
+  rprintf(rtest, "  HdrTest test_field_find_bench: %d fields, %d iterations, %d found\n", hdr.fields_count(), iterations,
+          found);
+  rprintf(rtest, "  HdrTest test_field_find_bench: present %" PRId64 " ns/lookup, absent %" PRId64 " ns/lookup\n",
+          (int64_t) (present_ns / ((int64_t) iterations * npresent)), (int64_t) (absent_ns / ((int64_t) iterations * nabsent)));
+
+  hdr.destroy();
+  return (failures_to_status("test_field_find_bench", failures));
+}
+
+/*-------------------------------------------------------------------------
+  -------------------------------------------------------------------------*/
+
+int
+HdrTest::test_hdr_heap_sizing()
+{
+  int failures = 0;
+  int first_grows = -1, last_grows = -1, last_coalesces = -1;
+  char name[32], value[128];
+
+  bri_box("test_hdr_heap_sizing");
+
+  // heaps are rounded up to their size class
+  for (int size = 1; size <= 5 * HDR_HEAP_DEFAULT_SIZE; size += 500) {
+    HdrHeap *heap = new_HdrHeap(size);
+    uint32_t expect = HDR_HEAP_DEFAULT_SIZE;
+
+    while (expect < (uint32_t) size)
+      expect *= 2;
+    if (heap->m_size != expect || heap->m_grow_count != 0 || heap->m_coalesce_count != 0) {
+      printf("FAILED: heap for %d bytes has %d bytes\n", size, heap->m_size);
+      ++failures;
+    }
+    heap->destroy();
+  }
+
+  // A run of cookie heavy requests that outgrow the default heap,
+  //   after which this thread hands out heaps they fit in
+  memset(value, 'c', sizeof(value) - 1);
+  value[sizeof(value) - 1] = '\0';
+  for (int i = 0; i < 200; i++) {
+    HTTPHdr hdr;
+
+    hdr.create(HTTP_TYPE_REQUEST, new_HdrHeap_sized(HDR_HEAP_USE_CLIENT_REQUEST));
+    for (int f = 0; f < 40; f++) {
+      snprintf(name, sizeof(name), "X-Cookie-%d", f);
+      hdr.value_set(name, (int) strlen(name), value, (int) strlen(value));
+    }
+    if (i == 0)
+      first_grows = hdr.m_heap->m_grow_count;
+    last_grows = hdr.m_heap->m_grow_count;
+    last_coalesces = hdr.m_heap->m_coalesce_count;
+    hdr_heap_size_observe(HDR_HEAP_USE_CLIENT_REQUEST, hdr.m_heap);
+    hdr.destroy();
+  }
+  if (first_grows == 0 || last_grows != 0 || last_coalesces != 0) {
+    printf("FAILED: first heap grew %d times, last grew %d times and coalesced %d times\n",
+           first_grows, last_grows, last_coalesces);
+    ++failures;
+  }
+
+  // Only one response in four needs a string heap, too few to preallocate one
+  for (int i = 0; i < 2 * 64; i++) {
+    HTTPHdr hdr;
+
+    hdr.create(HTTP_TYPE_RESPONSE, new_HdrHeap_sized(HDR_HEAP_USE_SERVER_RESPONSE));
+    if (i % 4 == 0)
+      hdr.value_set("X-Rare", 6, value, (int) strlen(value));
+    hdr_heap_size_observe(HDR_HEAP_USE_SERVER_RESPONSE, hdr.m_heap);
+    hdr.destroy();
+  }
+  HdrHeap *heap = new_HdrHeap_sized(HDR_HEAP_USE_SERVER_RESPONSE);
+  if (heap->m_read_write_heap) {
+    printf("FAILED: string heap preallocated when one header in four needed one\n");
+    ++failures;
+  }
+  heap->destroy();
+  rprintf(rtest, "  HdrTest test_hdr_heap_sizing: first heap grew %d times, last %d\n", first_grows, last_grows);
+
+  return (failures_to_status("test_hdr_heap_sizing", failures));
+}
+
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
 
@@ -70,6 +70,11 @@ private:
   int test_mime();
   int test_http();
   int test_http_mutation();
+  int test_mime_scan();
+  int test_parse_bench(int atype);
+  int test_hdrtoken_bench(int atype);
+  int test_field_find_bench(int atype);
+  int test_hdr_heap_sizing();
 
   int test_http_hdr_print_and_copy_aux(int testnum, const char *req, const char *req_tgt, const char *rsp,
                                        const char *rsp_tgt);
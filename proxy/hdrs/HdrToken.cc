@@ -28,21 +28,12 @@
 #include "HTTP.h"
 #include "HdrToken.h"
 #include "MIME.h"
-#include "Regex.h"
 #include "URL.h"
 
-/* 
- You SHOULD add to _hdrtoken_commonly_tokenized_strs, with the same ordering
- ** important, ordering matters **
- 
- You want a regexp like 'Accept' after "greedier" choices so it doesn't match 'Accept-Ranges' earlier than
- it should. The regexp are anchored (^Accept), but I dont see a way with the current system to 
- match the word ONLY without making _hdrtoken_strs a real PCRE, but then that breaks the hashing
- hdrtoken_hash("^Accept$") != hdrtoken_hash("Accept")
- 
- So, the current hack is to have "Accept" follow "Accept-.*", lame, I know
- 
-  /ericb
+/*
+ Every string in _hdrtoken_strs must be unique, ignoring case. They are
+ found through a perfect hash built by hdrtoken_hash_init(), which
+ aborts if two strings cannot be told apart.
 */
 
 const char *_hdrtoken_strs[] = {
@@ -322,16 +313,21 @@ int32_t hdrtoken_str_slotids[SIZEOF(_hdrtoken_strs)];     // wks_idx -> slot id
 uint64_t hdrtoken_str_masks[SIZEOF(_hdrtoken_strs)];      // wks_idx -> presence mask
 uint32_t hdrtoken_str_flags[SIZEOF(_hdrtoken_strs)];      // wks_idx -> flags
 
-DFA *hdrtoken_strs_dfa = NULL;
-
 /***********************************************************************
  *                                                                     *
  *                        H A S H    T A B L E                         *
  *                                                                     *
  ***********************************************************************/
 
-#define	HDRTOKEN_HASH_TABLE_SIZE	65536
-#define	HDRTOKEN_HASH_TABLE_MASK	HDRTOKEN_HASH_TABLE_SIZE-1
+// The well-known strings are kept in a perfect hash. A string's hash
+// picks one of HDRTOKEN_HASH_BUCKETS buckets, and the displacement of
+// that bucket, chosen at startup, maps each string of the bucket to a
+// slot no other string uses. A lookup is one probe plus a compare.
+
+#define HDRTOKEN_HASH_TABLE_BITS	8
+#define	HDRTOKEN_HASH_TABLE_SIZE	(1 << HDRTOKEN_HASH_TABLE_BITS)
+#define HDRTOKEN_HASH_BUCKET_BITS	6
+#define HDRTOKEN_HASH_BUCKETS		(1 << HDRTOKEN_HASH_BUCKET_BITS)
 
 struct HdrTokenHashBucket
 {
@@ -339,167 +335,36 @@ struct HdrTokenHashBucket
 };
 
 HdrTokenHashBucket hdrtoken_hash_table[HDRTOKEN_HASH_TABLE_SIZE];
-
-#define TINY_MASK(x) (((u_int32_t)1<<(x))-1)
+static uint16_t hdrtoken_hash_displacements[HDRTOKEN_HASH_BUCKETS];
 
 /**
-  basic FNV hash
+  basic FNV hash, ignoring the case of letters
 **/
-inline unsigned int
+inline uint32_t
 hdrtoken_hash(const unsigned char *string, unsigned int length)
 {
   const uint32_t InitialFNV = 2166136261U;
-  const int32_t FNVMultiple = 16777619;
+  const uint32_t FNVMultiple = 16777619;
 
   uint32_t hash = InitialFNV;
-  for(size_t i = 0; i < length; i++)  {
-      hash = hash ^ (toupper(string[i])); 
-      hash = hash * FNVMultiple;          
+  for (unsigned int i = 0; i < length; i++) {
+    hash = hash ^ (string[i] & 0xDF);   // 0xDF clears the lower case bit
+    hash = hash * FNVMultiple;
   }
-  return (((hash>>15) ^ hash) & TINY_MASK(15));
+  return hash;
 }
 
-/*-------------------------------------------------------------------------
-  -------------------------------------------------------------------------*/
+inline unsigned int
+hdrtoken_hash_bucket(uint32_t hash)
+{
+  return hash >> (32 - HDRTOKEN_HASH_BUCKET_BITS);
+}
 
-const char *_hdrtoken_commonly_tokenized_strs[] = {
-  // MIME Field names
-  "Accept-Charset",
-  "Accept-Encoding",
-  "Accept-Language",
-  "Accept-Ranges",
-  "Accept",
-  "Age",
-  "Allow",
-  "Approved",                   // NNTP
-  "Authorization",
-  "Bytes",                      // NNTP
-  "Cache-Control",
-  "Client-ip",
-  "Connection",
-  "Content-Base",
-  "Content-Encoding",
-  "Content-Language",
-  "Content-Length",
-  "Content-Location",
-  "Content-MD5",
-  "Content-Range",
-  "Content-Type",
-  "Control",                    // NNTP
-  "Cookie",
-  "Date",
-  "Distribution",               // NNTP
-  "Etag",
-  "Expect",
-  "Expires",
-  "Followup-To",                // NNTP
-  "From",
-  "Host",
-  "If-Match",
-  "If-Modified-Since",
-  "If-None-Match",
-  "If-Range",
-  "If-Unmodified-Since",
-  "Keep-Alive",
-  "Keywords",                   // NNTP
-  "Last-Modified",
-  "Lines",                      // NNTP
-  "Location",
-  "Max-Forwards",
-  "Message-ID",                 // NNTP
-  "MIME-Version",
-  "Newsgroups",                 // NNTP
-  "Organization",               // NNTP
-  "Path",                       // NNTP
-  "Pragma",
-  "Proxy-Authenticate",
-  "Proxy-Authorization",
-  "Proxy-Connection",
-  "Public",
-  "Range",
-  "References",                 // NNTP
-  "Referer",
-  "Reply-To",                   // NNTP
-  "Retry-After",
-  "Sender",                     // NNTP
-  "Server",
-  "Set-Cookie",
-  "Subject",                    // NNTP
-  "Summary",                    // NNTP
-  "Transfer-Encoding",
-  "Upgrade",
-  "User-Agent",
-  "Vary",
-  "Via",
-  "Warning",
-  "Www-Authenticate",
-  "Xref",                       // NNTP
-  "@DataInfo",                  // Internal Hack
-  
-  // Accept-Encoding
-  "compress",
-  "deflate",
-  "gzip",
-  "identity",
-  
-  // Cache-Control flags
-  "max-age",
-  "max-stale",
-  "min-fresh",
-  "must-revalidate",
-  "no-cache",
-  "no-store",
-  "no-transform",
-  "only-if-cached",
-  "private",
-  "proxy-revalidate",
-  "s-maxage",
-  "need-revalidate-once",
-  
-  // HTTP miscellaneous
-  "none",
-  "chunked",
-  "close",
-  
-  // URL schemes
-  "file",
-  "ftp",
-  "gopher",
-  "https",
-  "http",
-  "mailto",
-  "news",
-  "nntp",
-  "prospero",
-  "telnet",
-  "tunnel",
-  "wais",
-  "pnm",
-  "rtspu",
-  "rtsp",
-  "mmsu",
-  "mmst",
-  "mms",
-  
-  // HTTP methods
-  "CONNECT",
-  "DELETE",
-  "GET",
-  "POST",
-  "HEAD",
-  "ICP_QUERY",
-  "OPTIONS",
-  "PURGE",
-  "PUT",
-  "TRACE",
-  "PUSH",
-  "X-ID",
-  
-  // Header extensions
-  "X-Forwarded-For",
-  "TE",
-  
-};
+inline unsigned int
+hdrtoken_hash_slot(uint32_t hash, unsigned int displacement)
+{
+  return ((hash ^ (displacement * 0x9E3779B1U)) * 0x85EBCA6BU) >> (32 - HDRTOKEN_HASH_TABLE_BITS);
+}
 
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
@@ -507,32 +372,54 @@ const char *_hdrtoken_commonly_tokenized_strs[] = {
 void
 hdrtoken_hash_init()
 {
-  unsigned int i;
-  int num_collisions;
+  uint32_t hashes[SIZEOF(_hdrtoken_strs)];
+  int counts[HDRTOKEN_HASH_BUCKETS], order[HDRTOKEN_HASH_BUCKETS];
+  int i, j, b;
+
+  memset(hdrtoken_hash_table, 0, sizeof(hdrtoken_hash_table));
+  memset(counts, 0, sizeof(counts));
+  for (i = 0; i < (int) SIZEOF(_hdrtoken_strs); i++) {
+    hashes[i] = hdrtoken_hash((const unsigned char *) hdrtoken_strs[i], hdrtoken_str_lengths[i]);
+    ++counts[hdrtoken_hash_bucket(hashes[i])];
+  }
 
-  for (i = 0; i < HDRTOKEN_HASH_TABLE_SIZE; i++) {
-    hdrtoken_hash_table[i].wks = NULL;
+  // place the fullest buckets first, while most slots are still free
+  for (b = 0; b < HDRTOKEN_HASH_BUCKETS; b++) {
+    for (j = b; j > 0 && counts[order[j - 1]] < counts[b]; j--)
+      order[j] = order[j - 1];
+    order[j] = b;
   }
 
-  num_collisions = 0;
-  for (i = 0; i < (int) SIZEOF(_hdrtoken_commonly_tokenized_strs); i++) {
-    // convert the common string to the well-known token
-    unsigned const char *wks;
-    int wks_idx = hdrtoken_tokenize_dfa(_hdrtoken_commonly_tokenized_strs[i],
-                                        (int) strlen(_hdrtoken_commonly_tokenized_strs[i]),
-                                        (const char **) &wks);
-    ink_release_assert(wks_idx >= 0);
-
-    unsigned int slot = hdrtoken_hash(wks, hdrtoken_str_lengths[wks_idx]);
-    if (hdrtoken_hash_table[slot].wks) {
-      printf("ERROR: hdrtoken_hash_table[%u] collision: '%s' replacing '%s'\n",
-             slot, (const char*)wks, hdrtoken_hash_table[slot].wks);
-      ++num_collisions;
+  for (b = 0; b < HDRTOKEN_HASH_BUCKETS && counts[order[b]]; b++) {
+    unsigned int bucket = order[b], d, n;
+    int members[SIZEOF(_hdrtoken_strs)];
+    unsigned int slots[SIZEOF(_hdrtoken_strs)];
+
+    n = 0;
+    for (i = 0; i < (int) SIZEOF(_hdrtoken_strs); i++)
+      if (hdrtoken_hash_bucket(hashes[i]) == bucket)
+        members[n++] = i;
+
+    for (d = 0; d < 65536; d++) {
+      for (i = 0; i < (int) n; i++) {
+        slots[i] = hdrtoken_hash_slot(hashes[members[i]], d);
+        if (hdrtoken_hash_table[slots[i]].wks)
+          break;
+        for (j = 0; j < i && slots[j] != slots[i]; j++);
+        if (j < i)
+          break;
+      }
+      if (i == (int) n)
+        break;
     }
-    hdrtoken_hash_table[slot].wks = (const char *) wks;
+    if (d == 65536) {
+      printf("ERROR: hdrtoken_hash_table has no room for bucket %u (%u strings)\n", bucket, n);
+      abort();
+    }
+    hdrtoken_hash_displacements[bucket] = d;
+    for (i = 0; i < (int) n; i++)
+      hdrtoken_hash_table[slots[i]].wks = hdrtoken_strs[members[i]];
   }
-  if (num_collisions > 0)
-    abort();
 }
 
 
@@ -564,9 +451,6 @@ hdrtoken_init()
   if (!inited) {
     inited = 1;
 
-    hdrtoken_strs_dfa = NEW(new DFA);
-    hdrtoken_strs_dfa->compile(_hdrtoken_strs, SIZEOF(_hdrtoken_strs), (REFlags) (RE_CASE_INSENSITIVE));
-
     // all the tokenized hdrtoken strings are placed in a special heap,
     // and each string is prepended with a HdrTokenHeapPrefix ---
     // this makes it easy to tell that a string is a tokenized
@@ -611,13 +495,15 @@ hdrtoken_init()
       heap_size -= sstr_len;
     }
 
+    hdrtoken_hash_init();
+
     // Set the token types for certain tokens
     for (i = 0; _hdrtoken_strs_type_initializers[i].name != NULL; i++) {
       int wks_idx;
       HdrTokenHeapPrefix *prefix;
 
-      wks_idx = hdrtoken_tokenize_dfa(_hdrtoken_strs_type_initializers[i].name,
-                                      (int) strlen(_hdrtoken_strs_type_initializers[i].name));
+      wks_idx = hdrtoken_tokenize(_hdrtoken_strs_type_initializers[i].name,
+                                  (int) strlen(_hdrtoken_strs_type_initializers[i].name));
 
       ink_debug_assert((wks_idx >= 0) && (wks_idx < (int) SIZEOF(hdrtoken_strs)));
       // coverity[negative_returns]
@@ -625,17 +511,22 @@ hdrtoken_init()
       prefix->wks_token_type = _hdrtoken_strs_type_initializers[i].type;
     }
 
-    // Set special data for field names
+    // Set special data for field names, field names without a fixed slot
+    // id get the next free one
+    int32_t next_slotid = MIME_SLOTID_WWW_AUTHENTICATE + 1;
     for (i = 0; _hdrtoken_strs_field_initializers[i].name != NULL; i++) {
       int wks_idx;
       HdrTokenHeapPrefix *prefix;
 
-      wks_idx = hdrtoken_tokenize_dfa(_hdrtoken_strs_field_initializers[i].name,
-                                      (int) strlen(_hdrtoken_strs_field_initializers[i].name));
+      wks_idx = hdrtoken_tokenize(_hdrtoken_strs_field_initializers[i].name,
+                                  (int) strlen(_hdrtoken_strs_field_initializers[i].name));
 
       ink_debug_assert((wks_idx >= 0) && (wks_idx < (int) SIZEOF(hdrtoken_strs)));
       prefix = hdrtoken_index_to_prefix(wks_idx);
       prefix->wks_info.slotid = _hdrtoken_strs_field_initializers[i].slotid;
+      if (prefix->wks_info.slotid == MIME_SLOTID_NONE)
+        prefix->wks_info.slotid = next_slotid++;
+      ink_release_assert(prefix->wks_info.slotid < MIME_SLOTID_COUNT);
       prefix->wks_info.flags = _hdrtoken_strs_field_initializers[i].flags;
       prefix->wks_info.mask = _hdrtoken_strs_field_initializers[i].mask;
     }
@@ -648,32 +539,7 @@ hdrtoken_init()
       hdrtoken_str_masks[i] = prefix->wks_info.mask;    // parallel array for speed
       hdrtoken_str_flags[i] = prefix->wks_info.flags;   // parallel array for speed
     }
-
-    hdrtoken_hash_init();
-  }
-}
-
-/*-------------------------------------------------------------------------
-  -------------------------------------------------------------------------*/
-
-int
-hdrtoken_tokenize_dfa(const char *string, int string_len, const char **wks_string_out)
-{
-  int wks_idx;
-  
-  wks_idx = hdrtoken_strs_dfa->match(string, string_len);
-
-  if (wks_idx < 0)
-    wks_idx = -1;
-  if (wks_string_out) {
-    if (wks_idx >= 0)
-      *wks_string_out = hdrtoken_index_to_wks(wks_idx);
-    else
-      *wks_string_out = NULL;
   }
-  //printf("hdrtoken_tokenize_dfa(%d,*s) - return %d\n",string_len,string,wks_idx);
-
-  return (wks_idx);
 }
 
 /*-------------------------------------------------------------------------
@@ -694,10 +560,11 @@ hdrtoken_tokenize(const char *string, int string_len, const char **wks_string_ou
     return (wks_idx);
   }
 
-  unsigned int slot = hdrtoken_hash((const unsigned char *) string, (unsigned int) string_len);
+  uint32_t hash = hdrtoken_hash((const unsigned char *) string, (unsigned int) string_len);
+  unsigned int slot = hdrtoken_hash_slot(hash, hdrtoken_hash_displacements[hdrtoken_hash_bucket(hash)]);
   bucket = &(hdrtoken_hash_table[slot]);
   if ((bucket->wks != NULL) &&
-      (hdrtoken_wks_to_length(bucket->wks) == string_len)) {
+      (ptr_len_casecmp(bucket->wks, hdrtoken_wks_to_length(bucket->wks), string, string_len) == 0)) {
     wks_idx = hdrtoken_wks_to_index(bucket->wks);
     if (wks_string_out)
       *wks_string_out = bucket->wks;
@@ -102,7 +102,6 @@ enum HdrTokenInfoFlags
 #define MIME_FLAGS_HOPBYHOP	HTIF_HOPBYHOP
 #define MIME_FLAGS_PROXYAUTH	HTIF_PROXYAUTH
 
-extern DFA *hdrtoken_strs_dfa;
 extern int hdrtoken_num_wks;
 
 extern const char *hdrtoken_strs[];
@@ -119,7 +118,6 @@ extern uint32_t hdrtoken_str_flags[];
 ////////////////////////////////////////////////////////////////////////////
 
 extern void hdrtoken_init();
-extern int hdrtoken_tokenize_dfa(const char *string, int string_len, const char **wks_string_out = NULL);
 inkcoreapi extern int hdrtoken_tokenize(const char *string, int string_len, const char **wks_string_out = NULL);
 extern const char *hdrtoken_string_to_wks(const char *string);
 extern const char *hdrtoken_string_to_wks(const char *string, int length);
@@ -260,8 +258,9 @@ hdrtoken_wks_to_flags(const char *wks)
 //
 //      tokenized string mime slot ids
 //
-//      (up to 32 of the most common headers are allowed to be placed in
-//       special fast slots and contain presence bits and other info)
+//      (every field name has a slot id, which indexes the per header
+//       slot accelerators; the 32 most common ones are fixed here and
+//       the rest are numbered by hdrtoken_init)
 //
 ////////////////////////////////////////////////////////////////////////////
 
@@ -298,6 +297,8 @@ hdrtoken_wks_to_flags(const char *wks)
 #define MIME_SLOTID_VIA				30
 #define MIME_SLOTID_WWW_AUTHENTICATE		31
 
+#define MIME_SLOTID_COUNT			72
+
 #define MIME_SLOTID_NONE			-1
 
 ////////////////////////////////////////////////////////////////////////////
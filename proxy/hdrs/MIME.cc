@@ -30,6 +30,12 @@
 #include "HdrToken.h"
 #include "HdrUtils.h"
 #include "HttpCompat.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 /***********************************************************************
  *                                                                     *
@@ -443,13 +449,9 @@ mime_hdr_presence_unset(MIMEHdrImpl * h, int well_known_str_index)
 inline uint32_t
 mime_hdr_get_accelerator_slotnum(MIMEHdrImpl * mh, int32_t slot_id)
 {
-  ink_debug_assert((slot_id != MIME_SLOTID_NONE) && (slot_id < 32));
+  ink_debug_assert((slot_id != MIME_SLOTID_NONE) && (slot_id < MIME_SLOTID_COUNT));
 
-  uint32_t word_index = slot_id / 8;      // 4 words of 8 slots
-  uint32_t word = mh->m_slot_accelerators[word_index];    // 8 slots of 4 bits each
-  uint32_t nybble = slot_id % 8;  // which of the 8 nybbles?
-  uint32_t slot = ((word >> (nybble * 4)) & 15);  // grab the 4 bit slotnum
-  return slot;
+  return mh->m_slot_accelerators[slot_id];
 }
 
 /*-------------------------------------------------------------------------
@@ -458,18 +460,10 @@ mime_hdr_get_accelerator_slotnum(MIMEHdrImpl * mh, int32_t slot_id)
 inline void
 mime_hdr_set_accelerator_slotnum(MIMEHdrImpl * mh, int32_t slot_id, uint32_t slot_num)
 {
-  ink_debug_assert((slot_id != MIME_SLOTID_NONE) && (slot_id < 32));
-  ink_debug_assert(slot_num < 16);
+  ink_debug_assert((slot_id != MIME_SLOTID_NONE) && (slot_id < MIME_SLOTID_COUNT));
+  ink_debug_assert(slot_num <= MIME_FIELD_SLOTNUM_MASK);
 
-  uint32_t word_index = slot_id / 8;      // 4 words of 8 slots
-  uint32_t word = mh->m_slot_accelerators[word_index];    // 8 slots of 4 bits each
-  uint32_t nybble = slot_id % 8;  // which of the 8 nybbles?
-  uint32_t shift = nybble * 4;    // shift in chunks of 4 bits
-  uint32_t mask = ~(MIME_FIELD_SLOTNUM_MASK << shift);    // mask to zero out old slot
-  uint32_t graft = (slot_num << shift);   // plug to insert into slot
-  uint32_t new_word = (word & mask) | graft;      // new value
-
-  mh->m_slot_accelerators[word_index] = new_word;
+  mh->m_slot_accelerators[slot_id] = (uint8_t) slot_num;
 }
 
 /*-------------------------------------------------------------------------
@@ -487,6 +481,8 @@ mime_hdr_set_accelerators_and_presence_bits(MIMEHdrImpl * mh, MIMEField * field)
   slot_id = hdrtoken_index_to_slotid(field->m_wks_idx);
   if (slot_id != MIME_SLOTID_NONE) {
     slot_num = (field - &(mh->m_first_fblock.m_field_slots[0]));
+    if ((slot_num < 0) || (slot_num >= MIME_FIELD_BLOCK_SLOTS))
+      slot_num = mime_hdr_field_slotnum(mh, field);
     if ((slot_num >= 0) && (slot_num < MIME_FIELD_SLOTNUM_UNKNOWN))
       mime_hdr_set_accelerator_slotnum(mh, slot_id, slot_num);
     else
@@ -508,7 +504,7 @@ mime_hdr_unset_accelerators_and_presence_bits(MIMEHdrImpl * mh, MIMEField * fiel
 
   slot_id = hdrtoken_index_to_slotid(field->m_wks_idx);
   if (slot_id != MIME_SLOTID_NONE)
-    mime_hdr_set_accelerator_slotnum(mh, slot_id, MIME_FIELD_SLOTNUM_MAX);
+    mime_hdr_set_accelerator_slotnum(mh, slot_id, MIME_FIELD_SLOTNUM_ABSENT);
 }
 
 /*-------------------------------------------------------------------------
@@ -582,7 +578,7 @@ mime_hdr_sanity_check(MIMEHdrImpl * mh)
           if ((slot_id != MIME_SLOTID_NONE) &&
               (slot_index < MIME_FIELD_SLOTNUM_UNKNOWN) && (field->m_flags & MIME_FIELD_SLOT_FLAGS_DUP_HEAD)) {
             uint32_t slot_num = mime_hdr_get_accelerator_slotnum(mh, slot_id);
-            if (slot_num <= 14)
+            if (slot_num < MIME_FIELD_SLOTNUM_UNKNOWN)
               ink_release_assert(slot_num == slot_index);
           }
         } else {
@@ -1023,10 +1019,7 @@ void
 mime_hdr_init(MIMEHdrImpl * mh)
 {
   mh->m_presence_bits = 0;
-  mh->m_slot_accelerators[0] = 0xFFFFFFFF;
-  mh->m_slot_accelerators[1] = 0xFFFFFFFF;
-  mh->m_slot_accelerators[2] = 0xFFFFFFFF;
-  mh->m_slot_accelerators[3] = 0xFFFFFFFF;
+  memset(mh->m_slot_accelerators, MIME_FIELD_SLOTNUM_ABSENT, sizeof(mh->m_slot_accelerators));
 
   mime_hdr_cooked_stuff_init(mh, NULL);
 
@@ -1329,6 +1322,14 @@ mime_hdr_field_find(MIMEHdrImpl * mh, const char *field_name_str, int field_name
   ////////////////////////////////////////////
 
   is_wks = hdrtoken_is_wks(field_name_str);
+  if (!is_wks) {
+    // a name spelled out by the caller may still be a well-known one
+    const char *wks;
+    if (hdrtoken_tokenize(field_name_str, field_name_len, &wks) >= 0) {
+      field_name_str = wks;
+      is_wks = 1;
+    }
+  }
 #if TRACK_FIELD_FIND_CALLS
   Debug("http", "mime_hdr_field_find(hdr 0x%X, field %.*s): is_wks = %d\n", mh, field_name_len, field_name_str, is_wks);
 #endif
@@ -1348,7 +1349,13 @@ mime_hdr_field_find(MIMEHdrImpl * mh, const char *field_name_str, int field_name
     if (slot_id != MIME_SLOTID_NONE) {
       uint32_t slotnum = mime_hdr_get_accelerator_slotnum(mh, slot_id);
 
-      if (slotnum != MIME_FIELD_SLOTNUM_UNKNOWN) {
+      if (slotnum == MIME_FIELD_SLOTNUM_ABSENT) {
+#if TRACK_FIELD_FIND_CALLS
+        Debug("http", "mime_hdr_field_find(hdr 0x%X, field %.*s): MISS (due to slot accelerators)\n",
+              mh, field_name_len, field_name_str);
+#endif
+        return NULL;
+      } else if (slotnum != MIME_FIELD_SLOTNUM_UNKNOWN) {
         MIMEField *f = _mime_hdr_field_list_search_by_slotnum(mh, slotnum);
         ink_debug_assert((f == NULL) || f->is_live());
 #if TRACK_FIELD_FIND_CALLS
@@ -2311,7 +2318,8 @@ _mime_scanner_init(MIMEScanner * scanner)
   scanner->m_line_size = 0;
   scanner->m_line_length = 0;
   scanner->m_state = MIME_PARSE_BEFORE;
-
+  scanner->m_colon = -1;
+  scanner->m_hold_partial = false;
 }
 
 //////////////////////////////////////////////////////
@@ -2369,6 +2377,67 @@ mime_scanner_append(MIMEScanner * scanner, const char *data, int data_size)
   scanner->m_line_length += data_size;
 }
 
+/*-------------------------------------------------------------------------
+  Find the first LF in [s, e). If colon is not NULL, the first ':' before
+  the LF is also stored there, so the parser does not have to rescan the
+  line for it. Both are found in one pass, 16 or 32 bytes at a time.
+  -------------------------------------------------------------------------*/
+
+const char *
+mime_scan_lf(const char *s, const char *e, const char **colon)
+{
+  if (colon == NULL)
+    return (const char *) memchr(s, ParseRules::CHAR_LF, e - s);
+
+#if defined(__AVX2__)
+  __m256i lf32 = _mm256_set1_epi8(ParseRules::CHAR_LF);
+  __m256i co32 = _mm256_set1_epi8(':');
+  while (e - s >= 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *) s);
+    uint32_t lf = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, lf32));
+    uint32_t co = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, co32));
+    if (co) {
+      int i = __builtin_ctz(co);
+      if (!lf || i < __builtin_ctz(lf)) {
+        *colon = s + i;
+        return (const char *) memchr(s + i, ParseRules::CHAR_LF, e - s - i);
+      }
+    }
+    if (lf)
+      return s + __builtin_ctz(lf);
+    s += 32;
+  }
+#endif
+#if defined(__SSE2__)
+  __m128i lf16 = _mm_set1_epi8(ParseRules::CHAR_LF);
+  __m128i co16 = _mm_set1_epi8(':');
+  while (e - s >= 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *) s);
+    uint32_t lf = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, lf16));
+    uint32_t co = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, co16));
+    if (co) {
+      int i = __builtin_ctz(co);
+      if (!lf || i < __builtin_ctz(lf)) {
+        *colon = s + i;
+        return (const char *) memchr(s + i, ParseRules::CHAR_LF, e - s - i);
+      }
+    }
+    if (lf)
+      return s + __builtin_ctz(lf);
+    s += 16;
+  }
+#endif
+  for (; s < e; s++) {
+    if (*s == ParseRules::CHAR_LF)
+      return s;
+    if (*s == ':') {
+      *colon = s;
+      return (const char *) memchr(s, ParseRules::CHAR_LF, e - s);
+    }
+  }
+  return NULL;
+}
+
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
 
@@ -2393,6 +2462,7 @@ mime_scanner_get(MIMEScanner * S,
     ptrdiff_t runway = raw_input_e - raw_input_c; // remaining input.
     switch (S->m_state) {
     case MIME_PARSE_BEFORE: // waiting to find a field.
+      S->m_colon = -1;
       // If we find leading CR LF then it's the last line of the header.
       if (ParseRules::is_cr(*raw_input_c)
         && runway >= 2
@@ -2404,11 +2474,20 @@ mime_scanner_get(MIMEScanner * S,
         S->m_state = MIME_PARSE_INSIDE;
       }
       break;
-    case MIME_PARSE_INSIDE:
-      lf_ptr = static_cast<char const*>(memchr(raw_input_c, ParseRules::CHAR_LF, runway));
+    case MIME_PARSE_INSIDE: {
+      // Look for the colon along with the LF until one is found. Its
+      // offset counts the bytes already accumulated in m_line.
+      const char *colon = NULL;
+      lf_ptr = mime_scan_lf(raw_input_c, raw_input_e, S->m_colon < 0 ? &colon : NULL);
+      if (colon)
+        S->m_colon = S->m_line_length + (int) (colon - *raw_input_s);
       if (lf_ptr) {
         raw_input_c = lf_ptr + 1;
-        if (MIME_SCANNER_TYPE_LINE == raw_input_scan_type) {
+        // A CR that arrived without its LF leaves the blank line that
+        // ends the header here, and nothing can continue that.
+        bool blank = S->m_line_length + (raw_input_c - *raw_input_s) == 2 &&
+          ParseRules::is_cr(S->m_line_length ? S->m_line[0] : **raw_input_s);
+        if (MIME_SCANNER_TYPE_LINE == raw_input_scan_type || blank) {
           zret = PARSE_OK;
           S->m_state = MIME_PARSE_BEFORE;
         } else {
@@ -2418,6 +2497,7 @@ mime_scanner_get(MIMEScanner * S,
         raw_input_c = raw_input_e; // grab all that's available.
       }
       break;
+    }
     case MIME_PARSE_AFTER:
       // After a LF. Might be the end or a continuation.
       if (ParseRules::is_ws(*raw_input_c)) {
@@ -2459,8 +2539,15 @@ mime_scanner_get(MIMEScanner * S,
         zret = PARSE_ERROR; // Unterminated field.
       }
     } else if (data_size) {
-      // Inside a field but more data is expected. Save what we've got.
-      mime_scanner_append(S, *raw_input_s, data_size);
+      if (S->m_hold_partial && 0 == S->m_line_length) {
+        // The rest of the line will follow this input in memory, so
+        // leave it unconsumed and scan the whole line once it's there.
+        raw_input_c = *raw_input_s;
+        S->m_state = MIME_PARSE_BEFORE;
+      } else {
+        // Inside a field but more data is expected. Save what we've got.
+        mime_scanner_append(S, *raw_input_s, data_size);
+      }
       data_size = 0; // Don't append again.
     }
   } 
@@ -2580,8 +2667,9 @@ mime_parser_parse(MIMEParser * parser,
     if ((!ParseRules::is_token(*field_name_first)) && (*field_name_first != '@'))
       continue;                 // toss away garbage line
 
-    // find name last
-    colon = (char *) memchr(line_c, ':', (line_e - line_c));
+    // find name last, the scanner already located the colon
+    colon = scanner->m_colon < 0 ? NULL : line_c + scanner->m_colon;
+    ink_debug_assert(colon == (char *) memchr(line_c, ':', (line_e - line_c)));
     if (!colon)
       continue;                 // toss away garbage line
     field_name_last = colon - 1;
@@ -2649,11 +2737,10 @@ mime_hdr_describe(HdrHeapObjImpl * raw, bool recurse)
 
   MIMEHdrImpl *obj = (MIMEHdrImpl *) raw;
 
-  Debug("http", "\n\t[PBITS: 0x%08X%08X, SLACC: 0x%04X%04X%04X%04X, HEADBLK: 0x%X, TAILBLK: 0x%X]\n",
+  Debug("http", "\n\t[PBITS: 0x%08X%08X, HEADBLK: 0x%X, TAILBLK: 0x%X]\n",
         (uint32_t) ((obj->m_presence_bits >> 32) & (TOK_64_CONST(0xFFFFFFFF))),
         (uint32_t) ((obj->m_presence_bits >> 0) & (TOK_64_CONST(0xFFFFFFFF))),
-        obj->m_slot_accelerators[0], obj->m_slot_accelerators[1],
-        obj->m_slot_accelerators[2], obj->m_slot_accelerators[3], &(obj->m_first_fblock), obj->m_fblock_list_tail);
+        &(obj->m_first_fblock), obj->m_fblock_list_tail);
 
   Debug("http", "\t[CBITS: 0x%08X, T_MAXAGE: %d, T_SMAXAGE: %d, T_MAXSTALE: %d, T_MINFRESH: %d, PNO$: %d]\n",
         obj->m_cooked_stuff.m_cache_control.m_mask,
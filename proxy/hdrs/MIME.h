@@ -84,10 +84,11 @@ enum MimeParseState {
 
 #define MIME_FIELD_BLOCK_SLOTS			16
 
-#define	MIME_FIELD_SLOTNUM_BITS			4
+#define	MIME_FIELD_SLOTNUM_BITS			8
 #define	MIME_FIELD_SLOTNUM_MASK			((1 << MIME_FIELD_SLOTNUM_BITS) - 1)
 #define	MIME_FIELD_SLOTNUM_MAX			(MIME_FIELD_SLOTNUM_MASK - 1)
 #define MIME_FIELD_SLOTNUM_UNKNOWN		MIME_FIELD_SLOTNUM_MAX
+#define MIME_FIELD_SLOTNUM_ABSENT		MIME_FIELD_SLOTNUM_MASK
 
 /***********************************************************************
  *                                                                     *
@@ -226,7 +227,7 @@ struct MIMEHdrImpl:public HdrHeapObjImpl
 {
   // HdrHeapObjImpl is 4 bytes, so this will result in 4 bytes padding
   uint64_t m_presence_bits;
-  uint32_t m_slot_accelerators[4];
+  uint8_t m_slot_accelerators[MIME_SLOTID_COUNT];       // slot id -> slot number of the dup head
 
   MIMECooked m_cooked_stuff;
 
@@ -261,6 +262,8 @@ struct MIMEScanner
   int m_line_size;              // total allocated size of buffer
 //  int m_state;                  // state of scanning state machine
   MimeParseState m_state; ///< Parsing machine state.
+  int m_colon;                  ///< Offset of the first ':' in the line, -1 if none.
+  bool m_hold_partial;          ///< Leave an unfinished line in the input, the rest arrives right after it.
 };
 
 
@@ -658,6 +661,7 @@ void mime_field_value_append(HdrHeap * heap, MIMEHdrImpl * mh, MIMEField * field
 void mime_scanner_init(MIMEScanner * scanner);
 void mime_scanner_clear(MIMEScanner * scanner);
 void mime_scanner_append(MIMEScanner * scanner, const char *data, int data_size);
+const char *mime_scan_lf(const char *s, const char *e, const char **colon);
 MIMEParseResult mime_scanner_get(MIMEScanner * S, const char **raw_input_s, const char *raw_input_e,
                                  const char **output_s, const char **output_e,
                                  bool * output_shares_raw_input, bool raw_input_eof, int raw_input_scan_type);
@@ -858,6 +862,7 @@ class MIMEHdr:public HdrHeapSDKHandle
 public:
 
   MIMEHdrImpl * m_mime;
+  int m_field_lookups;          ///< field_find() and presence() calls made through this handle.
 
   MIMEHdr();
   ~MIMEHdr();
@@ -956,7 +961,7 @@ private:
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
 
-inline MIMEHdr::MIMEHdr():HdrHeapSDKHandle()
+inline MIMEHdr::MIMEHdr():HdrHeapSDKHandle(), m_field_lookups(0)
 {
 }
 
@@ -1055,6 +1060,7 @@ inline MIMEField *
 MIMEHdr::field_find(const char *name, int length)
 {
 //    ink_assert(valid());
+  ++m_field_lookups;
   return mime_hdr_field_find(m_mime, name, length);
 }
 
@@ -1132,6 +1138,7 @@ MIMEHdr::iter_get_next(MIMEFieldIter * iter)
 inline uint64_t
 MIMEHdr::presence(uint64_t mask)
 {
+  ++m_field_lookups;
   return (m_mime->m_presence_bits & mask);
 }
 
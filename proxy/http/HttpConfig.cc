@@ -1102,6 +1102,18 @@ register_stat_callbacks()
                      "proxy.process.http.total_x_redirect_count",
                      RECD_COUNTER, RECP_NULL,
                      (int) http_total_x_redirect_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS,
+                     "proxy.process.http.header_field_lookups",
+                     RECD_COUNTER, RECP_NULL,
+                     (int) http_header_field_lookups_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS,
+                     "proxy.process.http.header_heap_grows",
+                     RECD_COUNTER, RECP_NULL,
+                     (int) http_header_heap_grows_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS,
+                     "proxy.process.http.header_heap_coalesces",
+                     RECD_COUNTER, RECP_NULL,
+                     (int) http_header_heap_coalesces_stat, RecRawStatSyncSum);
 
 }
 
@@ -1352,6 +1364,9 @@ HttpConfig::startup()
   // Stat Page Info
   HttpEstablishStaticConfigByte(c.enable_http_info, "proxy.config.http.enable_http_info");
 
+  // splice(2) server to client pass-through
+  HttpEstablishStaticConfigByte(c.splice_enabled, "proxy.config.http.splice_enabled");
+
   // Support SRV records
   HttpEstablishStaticConfigLongLong(c.srv_enabled, "proxy.config.srv_enabled");
 
@@ -1577,6 +1592,7 @@ HttpConfig::reconfigure()
   params->default_buffer_size_index = m_master.default_buffer_size_index;
   params->default_buffer_water_mark = m_master.default_buffer_water_mark;
   params->enable_http_info = INT_TO_BOOL(m_master.enable_http_info);
+  params->splice_enabled = INT_TO_BOOL(m_master.splice_enabled);
   params->reverse_proxy_no_host_redirect = ats_strdup(m_master.reverse_proxy_no_host_redirect);
   params->reverse_proxy_no_host_redirect_len =
     params->reverse_proxy_no_host_redirect ? strlen(params->reverse_proxy_no_host_redirect) : 0;
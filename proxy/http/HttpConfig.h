@@ -276,6 +276,9 @@ enum
   http_ua_msecs_counts_other_unclassified_stat,
 
   http_total_x_redirect_stat,
+  http_header_field_lookups_stat,
+  http_header_heap_grows_stat,
+  http_header_heap_coalesces_stat,
 
   // Times
   http_total_transactions_time_stat,
@@ -767,6 +770,7 @@ public:
   MgmtInt default_buffer_size_index;
   MgmtInt default_buffer_water_mark;
   MgmtByte enable_http_info;
+  MgmtByte splice_enabled;
 
   // Cluster time delta is not a config variable,
   //  rather it is the time skew which the manager observes
@@ -962,6 +966,7 @@ HttpConfigParams::HttpConfigParams()
     default_buffer_size_index(0),
     default_buffer_water_mark(0),
     enable_http_info(0),
+    splice_enabled(0),
     cluster_time_delta(0),
     srv_enabled(0),
     redirection_enabled(1),
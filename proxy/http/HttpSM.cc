@@ -614,7 +614,7 @@ HttpSM::attach_client_session(HttpClientSession * client_vc, IOBufferReader * bu
   ua_buffer_reader = buffer_reader;
   ua_entry->vc_handler = &HttpSM::state_read_client_request_header;
   t_state.hdr_info.client_request.destroy();
-  t_state.hdr_info.client_request.create(HTTP_TYPE_REQUEST);
+  t_state.hdr_info.client_request.create(HTTP_TYPE_REQUEST, new_HdrHeap_sized(HDR_HEAP_USE_CLIENT_REQUEST));
   http_parser_init(&http_parser);
 
   // We first need to run the transaction start hook.  Since
@@ -913,7 +913,7 @@ HttpSM::setup_push_read_response_header()
   // Note: we must use destroy() here since clear()
   //  does not free the memory from the header
   t_state.hdr_info.server_response.destroy();
-  t_state.hdr_info.server_response.create(HTTP_TYPE_RESPONSE);
+  t_state.hdr_info.server_response.create(HTTP_TYPE_RESPONSE, new_HdrHeap_sized(HDR_HEAP_USE_SERVER_RESPONSE));
   http_parser_clear(&http_parser);
 
   // We already done the READ when we read the client
@@ -1545,6 +1545,7 @@ HttpSM::handle_api_return()
       setup_server_transfer();
       perform_cache_write_action();
       tunnel.tunnel_run();
+      setup_server_splice();
       break;
     }
   case HttpTransact::SERVE_FROM_CACHE:
@@ -5181,7 +5182,7 @@ HttpSM::setup_server_read_response_header()
   // Note: we must use destroy() here since clear()
   //  does not free the memory from the header
   t_state.hdr_info.server_response.destroy();
-  t_state.hdr_info.server_response.create(HTTP_TYPE_RESPONSE);
+  t_state.hdr_info.server_response.create(HTTP_TYPE_RESPONSE, new_HdrHeap_sized(HDR_HEAP_USE_SERVER_RESPONSE));
   http_parser_clear(&http_parser);
   server_response_hdr_bytes = 0;
   milestones.server_read_header_done = 0;
@@ -5792,6 +5793,31 @@ HttpSM::setup_server_transfer()
   tunnel.set_producer_chunking_action(p, client_response_hdr_bytes, action);
 }
 
+// Let the net layer splice the response body from the server socket
+// straight into the client socket when the tunnel only passes it along:
+// one user agent consumer, no cache write, no transform and no chunking
+// changes. Anything else keeps going through the IOBuffers.
+void
+HttpSM::setup_server_splice()
+{
+  if (!t_state.http_config_param->splice_enabled || !server_session || !ua_session)
+    return;
+
+  HttpTunnelProducer *p = tunnel.get_producer(server_entry->vc);
+  if (!p || !p->alive || !p->read_vio || p->num_consumers != 1 ||
+      p->chunking_action != TCA_PASSTHRU_DECHUNKED_CONTENT)
+    return;
+
+  HttpTunnelConsumer *c = p->consumer_list.head;
+  if (c->vc_type != HT_HTTP_CLIENT || !c->alive || !c->write_vio)
+    return;
+
+  NetVConnection *server_vc = server_session->get_netvc();
+  NetVConnection *ua_vc = ua_session->get_netvc();
+  if (server_vc && ua_vc && server_vc->is_splice_capable() && server_vc->set_splice_target(ua_vc))
+    Debug("http", "[%" PRId64 "] splicing server response to client", sm_id);
+}
+
 void
 HttpSM::setup_push_transfer_to_cache()
 {
@@ -6121,6 +6147,32 @@ HttpSM::update_stats()
                                            server_response_body_bytes,
                                            pushed_response_hdr_bytes,
                                            pushed_response_body_bytes, t_state.cache_info.action);
+
+  int field_lookups = t_state.hdr_info.client_request.m_field_lookups + t_state.hdr_info.client_response.m_field_lookups +
+    t_state.hdr_info.server_request.m_field_lookups + t_state.hdr_info.server_response.m_field_lookups +
+    t_state.hdr_info.transform_response.m_field_lookups;
+  HTTP_SUM_DYN_STAT(http_header_field_lookups_stat, field_lookups);
+  Debug("http_seq", "[update_stats] %d header field lookups", field_lookups);
+
+  HTTPHdr *hdrs[] = { &t_state.hdr_info.client_request, &t_state.hdr_info.client_response,
+                      &t_state.hdr_info.server_request, &t_state.hdr_info.server_response,
+                      &t_state.hdr_info.transform_response };
+  int heap_grows = 0, heap_coalesces = 0;
+  for (unsigned i = 0; i < sizeof(hdrs) / sizeof(hdrs[0]); i++) {
+    if (hdrs[i]->valid()) {
+      heap_grows += hdrs[i]->m_heap->m_grow_count;
+      heap_coalesces += hdrs[i]->m_heap->m_coalesce_count;
+    }
+  }
+  HTTP_SUM_DYN_STAT(http_header_heap_grows_stat, heap_grows);
+  HTTP_SUM_DYN_STAT(http_header_heap_coalesces_stat, heap_coalesces);
+  Debug("http_seq", "[update_stats] header heaps grew %d times, coalesced %d times", heap_grows, heap_coalesces);
+
+  // Let this thread size the next headers after these
+  if (t_state.hdr_info.client_request.valid())
+    hdr_heap_size_observe(HDR_HEAP_USE_CLIENT_REQUEST, t_state.hdr_info.client_request.m_heap);
+  if (t_state.hdr_info.server_response.valid())
+    hdr_heap_size_observe(HDR_HEAP_USE_SERVER_RESPONSE, t_state.hdr_info.server_response.m_heap);
 /*
     if (is_action_tag_set("http_handler_times")) {
 	print_all_http_handler_times();
@@ -432,6 +432,7 @@ protected:
   void setup_server_send_request();
   void setup_server_send_request_api();
   void setup_server_transfer();
+  void setup_server_splice();
   void setup_server_transfer_to_cache_only();
   void setup_cache_read_transfer();
   void setup_internal_transfer(HttpSMHandler handler);